@@ -1,162 +1,145 @@
 #include <bits/stdc++.h>
 #include "search_algorithms.hpp"
+#include "perf_counters.hpp"
+#include "corpus_generator.hpp"
+#include "bench_report.hpp"
 using namespace std;
 
-// ---------------------- Наївний пошук ----------------------
-// Рахує кількість входжень КОЖНОГО патерну + загальну
-size_t naive_search(const string &text,
-                    const vector<string> &patterns,
-                    vector<size_t> &per_pattern) {
-    per_pattern.assign(patterns.size(), 0);
-    size_t total_matches = 0;
-
-    for (size_t i = 0; i < patterns.size(); ++i) {
-        const string &p = patterns[i];
-        if (p.empty()) continue;
-
-        for (size_t pos = 0; pos + p.size() <= text.size(); ++pos) {
-            bool ok = true;
-            for (size_t j = 0; j < p.size(); ++j) {
-                if (text[pos + j] != p[j]) {
-                    ok = false;
-                    break;
-                }
-            }
-            if (ok) {
-                ++per_pattern[i];
-                ++total_matches;
-            }
-        }
-    }
+// ---------------------- Вимір часу (в мікросекундах) ----------------------
 
-    return total_matches;
+template <typename Func>
+long long measure_us(Func f) {
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    f();
+    auto end = high_resolution_clock::now();
+    return duration_cast<microseconds>(end - start).count();
 }
 
-// ---------------------- Алгоритм Ахо-Корасік ----------------------
-// Алфавіт: a..z / A..Z. Інші символи ігноруємо.
-
-struct AhoNode {
-    static const int ALPHA = 26; // 'a'..'z'
-    int next[ALPHA];
-    int link;
-    vector<int> out;  // індекси патернів
+// ---------------------- Набір бенчмарків (--json) ----------------------
+// Кожен рушій запускається на кожній парі словник × корпус кілька разів,
+// а ще один, інструментований, запуск дає апаратні лічильники.
 
-    AhoNode() {
-        fill(begin(next), end(next), -1);
-        link = -1;
-    }
+struct BenchOptions {
+    string json_path;       // куди записати JSON (порожньо — набір не запускається)
+    size_t bytes = 1 << 20; // розмір кожного корпусу
+    int iterations = 11;    // кількість вимірювань на комбінацію
+    uint64_t seed = 42;     // seed генератора корпусів
 };
 
-struct AhoCorasick {
-    vector<AhoNode> trie;
-    vector<string> patterns;
+static const size_t NAIVE_MAX_PATTERNS = 100; // наївний пошук на великих словниках надто повільний
 
-    AhoCorasick() {
-        trie.emplace_back(); // root = 0
-    }
+// однакова семантика для всіх рушіїв, щоб кількості збігів збігалися
+static const MatchOptions SEMANTICS = {CaseMode::AsciiFold, Scope::WithinWord};
 
-    static int char_id(char c) {
-        if (c >= 'a' && c <= 'z') return c - 'a';
-        if (c >= 'A' && c <= 'Z') return c - 'A';
-        return -1; // не літера
+template <typename Func>
+BenchResult run_bench(const string &engine, const string &dictionary, const string &corpus,
+                      const string &text, size_t n_patterns, int iterations,
+                      PerfCounters &perf, Func f) {
+    BenchResult r;
+    r.engine = engine;
+    r.dictionary = dictionary;
+    r.corpus = corpus;
+    r.bytes = text.size();
+    r.patterns = n_patterns;
+
+    for (int i = 0; i < iterations; ++i) {
+        r.samples_us.push_back((double)measure_us([&]() { r.matches = f(); }));
     }
-
-    void add_pattern(const string &s, int idx) {
-        int v = 0;
-        for (char c : s) {
-            int id = char_id(c);
-            if (id == -1) continue; // пропускаємо не-літери
-            if (trie[v].next[id] == -1) {
-                trie[v].next[id] = (int)trie.size();
-                trie.emplace_back();
-            }
-            v = trie[v].next[id];
-        }
-        trie[v].out.push_back(idx);
+    PerfSample sample = measure_perf(perf, [&]() { f(); });
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (sample.valid[e]) r.counters.push_back({PerfCounters::event_name(e), sample.value[e]});
     }
+    return r;
+}
 
-    void build_automaton(const vector<string> &patterns_) {
-        patterns = patterns_;
-        // будуємо бор
-        for (int i = 0; i < (int)patterns.size(); ++i) {
-            if (!patterns[i].empty()) add_pattern(patterns[i], i);
-        }
-
-        queue<int> q;
-        trie[0].link = 0;
-
-        // переходи з кореня
-        for (int c = 0; c < AhoNode::ALPHA; ++c) {
-            int to = trie[0].next[c];
-            if (to != -1) {
-                trie[to].link = 0;
-                q.push(to);
-            } else {
-                trie[0].next[c] = 0;
-            }
-        }
-
-        // BFS
-        while (!q.empty()) {
-            int v = q.front(); q.pop();
-            int link = trie[v].link;
+static vector<BenchResult> run_suite(const BenchOptions &opt, const vector<string> &animals,
+                                     const string &animal_text) {
+    vector<pair<string, vector<string>>> dictionaries = {
+        {"animals", animals},
+        {"english_1k", english_like_words(1000, opt.seed)},
+        {"random_10k", random_word_dictionary(10000, 3, 12, opt.seed)},
+        {"shared_prefix_1k", shared_prefix_dictionary(1000, 32, opt.seed)},
+        {"suffix_chain_64", suffix_chain_dictionary(64, 'a')},
+    };
 
-            // наслідуємо виходи
-            for (int pattern_idx : trie[link].out) {
-                trie[v].out.push_back(pattern_idx);
-            }
+    string animals_corpus;
+    while (animals_corpus.size() < opt.bytes) animals_corpus += animal_text + "\n";
+    animals_corpus.resize(opt.bytes);
+    vector<pair<string, string>> shared_corpora = {
+        {"animals", animals_corpus},
+        {"zipf", zipf_text(opt.bytes, english_like_words(50000, opt.seed), 1.07, opt.seed)},
+        {"random", random_bytes(opt.bytes, opt.seed)},
+    };
 
-            for (int c = 0; c < AhoNode::ALPHA; ++c) {
-                int to = trie[v].next[c];
-                if (to != -1) {
-                    trie[to].link = trie[link].next[c];
-                    q.push(to);
-                } else {
-                    trie[v].next[c] = trie[link].next[c];
-                }
+    PerfCounters perf;
+    vector<BenchResult> results;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+
+    for (const auto &dict : dictionaries) {
+        const vector<string> &patterns = dict.second;
+        AhoCorasick aho;
+        results.push_back(run_bench("aho_build", dict.first, "none", string(), patterns.size(),
+                                    opt.iterations, perf, [&]() {
+            AhoCorasick fresh;
+            fresh.build_automaton(patterns, SEMANTICS);
+            return fresh.trie.size();
+        }));
+        aho.build_automaton(patterns, SEMANTICS);
+
+        vector<pair<string, string>> corpora = shared_corpora;
+        corpora.push_back({"dense", dense_text(opt.bytes, patterns, 0.5, opt.seed)});
+
+        for (const auto &corpus : corpora) {
+            const string &text = corpus.second;
+            vector<size_t> counts;
+            SparseCounts sparse;
+
+            if (patterns.size() <= NAIVE_MAX_PATTERNS) {
+                results.push_back(run_bench("naive", dict.first, corpus.first, text, patterns.size(),
+                                            opt.iterations, perf, [&]() {
+                    return naive_search(text, patterns, counts, SEMANTICS);
+                }));
             }
+            results.push_back(run_bench("aho", dict.first, corpus.first, text, patterns.size(),
+                                        opt.iterations, perf, [&]() {
+                return aho.search(text, counts);
+            }));
+            results.push_back(run_bench("aho_sparse", dict.first, corpus.first, text, patterns.size(),
+                                        opt.iterations, perf, [&]() {
+                return aho.search(text, sparse);
+            }));
+            results.push_back(run_bench("aho_parallel", dict.first, corpus.first, text, patterns.size(),
+                                        opt.iterations, perf, [&]() {
+                return parallel_search(aho, text, counts, threads);
+            }));
         }
     }
+    return results;
+}
 
-    // Рахуємо кількість входжень кожного патерну + загальну
-    size_t search(const string &text, vector<size_t> &per_pattern) const {
-        per_pattern.assign(patterns.size(), 0);
-        size_t total_matches = 0;
-        int v = 0;
-
-        for (char ch : text) {
-            int id = char_id(ch);
-            if (id == -1) {
-                v = 0; // не літера — повертаємось у корінь
-                continue;
-            }
-            v = trie[v].next[id];
-
-            // усі патерни, що закінчуються в цій вершині
-            for (int pattern_idx : trie[v].out) {
-                ++per_pattern[pattern_idx];
-                ++total_matches;
-            }
-        }
-
-        return total_matches;
+static bool parse_args(int argc, char **argv, BenchOptions &opt) {
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        if (arg == "--json") opt.json_path = argv[++i];
+        else if (arg == "--size") opt.bytes = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--iterations") opt.iterations = max(1, atoi(argv[++i]));
+        else if (arg == "--seed") opt.seed = strtoull(argv[++i], nullptr, 10);
+        else return false;
     }
-};
-
-// ---------------------- Вимір часу (в мікросекундах) ----------------------
-
-template <typename Func>
-long long measure_us(Func f) {
-    using namespace std::chrono;
-    auto start = high_resolution_clock::now();
-    f();
-    auto end = high_resolution_clock::now();
-    return duration_cast<microseconds>(end - start).count();
+    return true;
 }
 
 // ---------------------- main ----------------------
 
-int main() {
+int main(int argc, char **argv) {
+    BenchOptions opt;
+    if (!parse_args(argc, argv, opt)) {
+        cerr << "Usage: " << argv[0] << " [--json FILE] [--size BYTES] [--iterations N] [--seed S]\n";
+        return 2;
+    }
+
     // ==== Вбудований словник: 10 назв тварин ====
     vector<string> patterns = {
         "cat",
@@ -213,17 +196,30 @@ Animals are important, and people should be kind to them.)";
         text += "\n";
     }
 
+    // ---------- Апаратні лічильники (якщо доступні) ----------
+    // Лічильники знімаються окремим прогоном після замірюваного, як у run_bench,
+    // щоб час не включав вартість увімкнення й зчитування лічильників.
+    PerfCounters perf;
+    PerfSample naive_perf, build_perf, aho_perf;
+
     // ---------- Наївний пошук ----------
     vector<size_t> naive_per_pattern;
     size_t naive_total = 0;
     long long naive_time_us = measure_us([&]() {
-        naive_total = naive_search(text, patterns, naive_per_pattern);
+        naive_total = naive_search(text, patterns, naive_per_pattern, SEMANTICS);
+    });
+    naive_perf = measure_perf(perf, [&]() {
+        naive_search(text, patterns, naive_per_pattern, SEMANTICS);
     });
 
     // ---------- Ахо-Корасік ----------
     AhoCorasick aho;
     long long build_time_us = measure_us([&]() {
-        aho.build_automaton(patterns);
+        aho.build_automaton(patterns, SEMANTICS);
+    });
+    AhoCorasick perf_aho;
+    build_perf = measure_perf(perf, [&]() {
+        perf_aho.build_automaton(patterns, SEMANTICS);
     });
 
     vector<size_t> aho_per_pattern;
@@ -231,24 +227,35 @@ Animals are important, and people should be kind to them.)";
     long long aho_time_us = measure_us([&]() {
         aho_total = aho.search(text, aho_per_pattern);
     });
+    aho_perf = measure_perf(perf, [&]() {
+        aho.search(text, aho_per_pattern);
+    });
 
     // ---------- Результати ----------
     cout << "Number of patterns: " << patterns.size() << "\n";
     cout << "Base text length:   " << base_text.size() << " characters\n";
     cout << "Repeat count:       " << REPEAT << "\n";
-    cout << "Full text length:   " << text.size() << " characters\n\n";
+    cout << "Full text length:   " << text.size() << " characters\n";
+    cout << "Match semantics:    case-insensitive, within words\n\n";
 
     cout << "Naive search:\n";
     cout << "  Total matches: " << naive_total << "\n";
     cout << "  Time:          " << naive_time_us << " microseconds ("
-         << fixed << setprecision(3) << naive_time_us / 1000.0 << " ms)\n\n";
+         << fixed << setprecision(3) << naive_time_us / 1000.0 << " ms)\n";
+    print_perf(cout, naive_perf, "    ");
+    cout << "\n";
 
     cout << "Aho–Corasick:\n";
     cout << "  Build time:    " << build_time_us << " microseconds ("
          << fixed << setprecision(3) << build_time_us / 1000.0 << " ms)\n";
+    print_perf(cout, build_perf, "    ");
+    cout << "  Automaton:\n";
+    print_stats(cout, aho.stats(), "    ");
     cout << "  Total matches: " << aho_total << "\n";
     cout << "  Search time:   " << aho_time_us << " microseconds ("
-         << fixed << setprecision(3) << aho_time_us / 1000.0 << " ms)\n\n";
+         << fixed << setprecision(3) << aho_time_us / 1000.0 << " ms)\n";
+    print_perf(cout, aho_perf, "    ");
+    cout << "\n";
 
     if (naive_total != aho_total) {
         cout << "[WARNING] Different total match counts, check implementation.\n\n";
@@ -260,6 +267,29 @@ Animals are important, and people should be kind to them.)";
              << naive_per_pattern[i] << " / " << aho_per_pattern[i] << "\n";
     }
 
+    // ---------- Машинозчитуваний набір бенчмарків ----------
+    if (!opt.json_path.empty()) {
+        vector<BenchResult> results = run_suite(opt, patterns, base_text);
+
+        cout << "\nBenchmark suite (" << opt.iterations << " iterations, "
+             << opt.bytes << " bytes per corpus):\n";
+        for (const BenchResult &r : results) {
+            double p50 = percentile(r.samples_us, 0.5);
+            cout << "  " << left << setw(48) << r.key() << right
+                 << " p50 " << setw(10) << fixed << setprecision(1) << p50 << " us";
+            if (r.bytes > 0 && p50 > 0) cout << "  " << setw(8) << r.bytes / p50 << " MB/s";
+            cout << "\n";
+        }
+
+        ofstream out(opt.json_path);
+        if (!out) {
+            cerr << "Cannot write " << opt.json_path << "\n";
+            return 1;
+        }
+        write_bench_json(out, results);
+        cout << "Results written to " << opt.json_path << "\n";
+    }
+
     return 0;
 }
 
@@ -0,0 +1,190 @@
+#include "automaton_cache.hpp"
+#include <chrono>
+using namespace std;
+
+/**
+ * @brief Додає байти до хешу FNV-1a.
+ * @param h Поточний хеш.
+ * @param data Байти.
+ * @param size Кількість байтів.
+ * @return Оновлений хеш.
+ */
+static uint64_t fnv1a(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Хеш вмісту словника.
+ *
+ * Довжина кожного шаблону хешується перед ним, тож {"ab", "c"} і
+ * {"a", "bc"} мають різні хеші.
+ *
+ * @param patterns Шаблони словника.
+ * @param options Семантика збігу.
+ * @return 64-бітний хеш.
+ */
+uint64_t dictionary_hash(const vector<string> &patterns, const MatchOptions &options) {
+    uint64_t h = 14695981039346656037ULL;
+    uint64_t header[3] = {(uint64_t)options.case_mode, (uint64_t)options.scope, (uint64_t)patterns.size()};
+    h = fnv1a(h, header, sizeof(header));
+    for (const string &p : patterns) {
+        uint64_t len = p.size();
+        h = fnv1a(h, &len, sizeof(len));
+        h = fnv1a(h, p.data(), p.size());
+    }
+    return h;
+}
+
+/**
+ * @brief Створює порожній кеш.
+ * @param budget Бюджет пам'яті в байтах.
+ */
+AutomatonCache::AutomatonCache(size_t budget) : budget_bytes(budget), counters() {}
+
+/**
+ * @brief Перевіряє, що готовий автомат побудовано саме за цим словником.
+ * @param automaton Автомат.
+ * @param patterns Шаблони словника.
+ * @param options Семантика збігу.
+ * @return true, якщо словник і семантика збігаються.
+ */
+static bool same_dictionary(const AhoCorasick &automaton, const vector<string> &patterns,
+                            const MatchOptions &options) {
+    return automaton.options.case_mode == options.case_mode &&
+           automaton.options.scope == options.scope &&
+           automaton.patterns == patterns;
+}
+
+/**
+ * @brief Перевіряє, чи завершилася побудова запису винятком.
+ * @param entry Майбутній автомат запису.
+ * @return true, якщо побудова вже завершилася винятком.
+ */
+static bool build_failed(const shared_future<AutomatonCache::Handle> &entry) {
+    if (entry.wait_for(chrono::seconds(0)) != future_status::ready) return false;
+    try {
+        entry.get();
+    } catch (...) {
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Повертає автомат для словника, будуючи його за потреби.
+ *
+ * Під блокуванням лише шукається або вставляється запис з обіцянкою;
+ * сама побудова та підрахунок пам'яті відбуваються без блокування. Якщо
+ * побудова кинула виняток (наприклад, std::bad_alloc), він передається
+ * всім, хто чекав на цей запис, а запис видаляється з кешу.
+ *
+ * @param patterns Шаблони словника.
+ * @param options Семантика збігу.
+ * @return Спільне посилання на незмінний автомат.
+ */
+AutomatonCache::Handle AutomatonCache::get(const vector<string> &patterns, const MatchOptions &options) {
+    uint64_t h = dictionary_hash(patterns, options);
+    promise<Handle> built;
+    shared_future<Handle> pending;
+    bool build = false;
+
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = index.find(h);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            pending = it->second->automaton;
+            ++counters.hits;
+        } else {
+            pending = built.get_future().share();
+            lru.push_front({h, pending, 0});
+            index[h] = lru.begin();
+            ++counters.misses;
+            ++counters.entries;
+            build = true;
+        }
+    }
+
+    if (!build) {
+        Handle automaton = pending.get();
+        if (same_dictionary(*automaton, patterns, options)) return automaton;
+
+        // колізія хешу: словник будується окремо і не кешується
+        shared_ptr<AhoCorasick> own = make_shared<AhoCorasick>();
+        own->build_automaton(patterns, options);
+        return own;
+    }
+
+    shared_ptr<AhoCorasick> automaton;
+    size_t bytes = 0;
+    try {
+        automaton = make_shared<AhoCorasick>();
+        automaton->build_automaton(patterns, options);
+        bytes = automaton->stats().total_bytes;
+    } catch (...) {
+        // очікувачі отримують ту саму помилку, а запис прибирається, щоб
+        // наступний запит спробував побудувати автомат знову
+        built.set_exception(current_exception());
+        lock_guard<mutex> guard(lock);
+        auto it = index.find(h);
+        if (it != index.end() && build_failed(it->second->automaton)) {
+            lru.erase(it->second);
+            index.erase(it);
+            --counters.entries;
+        }
+        throw;
+    }
+    Handle handle = automaton;
+    built.set_value(handle);
+
+    lock_guard<mutex> guard(lock);
+    auto it = index.find(h);
+    // запис могли витіснити чи очистити під час побудови
+    if (it == index.end() || it->second->bytes != 0) return handle;
+    const shared_future<Handle> &entry = it->second->automaton;
+    if (entry.wait_for(chrono::seconds(0)) != future_status::ready || build_failed(entry) ||
+        entry.get() != handle) {
+        return handle;
+    }
+    it->second->bytes = bytes;
+    counters.bytes += bytes;
+
+    // від найстарішого: сам h і записи в побудові (bytes == 0) пропускаються —
+    // перший має лишитися, а витіснення других нічого не звільняє й
+    // викидає побудову, на яку хтось чекає
+    for (auto victim = lru.end(); counters.bytes > budget_bytes && victim != lru.begin();) {
+        --victim;
+        if (victim->hash == h || victim->bytes == 0) continue;
+        counters.bytes -= victim->bytes;
+        --counters.entries;
+        ++counters.evictions;
+        index.erase(victim->hash);
+        victim = lru.erase(victim);
+    }
+    return handle;
+}
+
+/**
+ * @brief Видаляє всі автомати з кешу.
+ */
+void AutomatonCache::clear() {
+    lock_guard<mutex> guard(lock);
+    lru.clear();
+    index.clear();
+    counters.entries = 0;
+    counters.bytes = 0;
+}
+
+/**
+ * @brief Знімок лічильників кешу.
+ * @return Лічильники.
+ */
+AutomatonCacheStats AutomatonCache::stats() const {
+    lock_guard<mutex> guard(lock);
+    return counters;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "search_algorithms.hpp"
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Обчислює хеш вмісту словника разом із семантикою збігу.
+ *
+ * FNV-1a по довжині та байтах кожного шаблону по черзі, тож порядок
+ * шаблонів враховується (він визначає індекси в результатах).
+ *
+ * @param patterns Шаблони словника.
+ * @param options Семантика збігу.
+ * @return 64-бітний хеш.
+ */
+uint64_t dictionary_hash(const std::vector<std::string> &patterns, const MatchOptions &options);
+
+/**
+ * @brief Лічильники роботи кешу автоматів.
+ */
+struct AutomatonCacheStats {
+    size_t hits;      ///< Запити, обслужені готовим або вже побудовуваним автоматом.
+    size_t misses;    ///< Запити, що спричинили побудову.
+    size_t evictions; ///< Автомати, витіснені через бюджет пам'яті.
+    size_t entries;   ///< Автомати в кеші зараз.
+    size_t bytes;     ///< Пам'ять автоматів у кеші (AhoStats::total_bytes).
+};
+
+/**
+ * @brief Реєстр побудованих автоматів із витісненням LRU за бюджетом пам'яті.
+ *
+ * Автомат шукається за dictionary_hash; при збігу хешу шаблони й семантика
+ * порівнюються повністю, тож колізія не підмінить словник. Автомати
+ * віддаються як std::shared_ptr на незмінний об'єкт: пошук потокобезпечний
+ * без блокувань, а витіснений автомат живе, доки ним користуються.
+ *
+ * Побудова виконується поза блокуванням кешу. Паралельні запити того самого
+ * словника чекають на одну побудову замість запуску власної.
+ */
+struct AutomatonCache {
+    typedef std::shared_ptr<const AhoCorasick> Handle;
+
+    /**
+     * @brief Запис кешу.
+     */
+    struct Entry {
+        uint64_t hash;                      ///< Хеш словника.
+        std::shared_future<Handle> automaton; ///< Автомат (готовий або в побудові).
+        size_t bytes;                       ///< Пам'ять автомата (0, поки він будується).
+    };
+
+    size_t budget_bytes; ///< Бюджет пам'яті для всіх автоматів у кеші.
+    std::list<Entry> lru; ///< Записи від найновішого до найстарішого.
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index; ///< Хеш -> запис.
+    AutomatonCacheStats counters; ///< Лічильники (entries і bytes оновлюються разом із lru).
+    mutable std::mutex lock;      ///< Захищає всі поля вище.
+
+    /**
+     * @brief Створює порожній кеш.
+     * @param budget Бюджет пам'яті в байтах.
+     */
+    explicit AutomatonCache(size_t budget);
+
+    AutomatonCache(const AutomatonCache &) = delete;
+    AutomatonCache &operator=(const AutomatonCache &) = delete;
+
+    /**
+     * @brief Повертає автомат для словника, будуючи його за потреби.
+     *
+     * Щойно побудований автомат лишається в кеші, навіть якщо сам
+     * перевищує бюджет; решта готових витісняються від найстарішого, доки
+     * сумарна пам'ять не вкладеться в нього. Автомати в побудові не
+     * витісняються: їхня пам'ять ще не врахована, і кожен із них сам
+     * застосує бюджет, коли побудова завершиться.
+     *
+     * @param patterns Шаблони словника.
+     * @param options Семантика збігу.
+     * @return Спільне посилання на незмінний автомат.
+     */
+    Handle get(const std::vector<std::string> &patterns,
+               const MatchOptions &options = {CaseMode::AsciiFold, Scope::WithinWord});
+
+    /**
+     * @brief Видаляє всі автомати з кешу (видані посилання лишаються дійсними).
+     */
+    void clear();
+
+    /**
+     * @brief Повертає знімок лічильників.
+     * @return Лічильники кешу.
+     */
+    AutomatonCacheStats stats() const;
+};
@@ -0,0 +1,67 @@
+#include <bits/stdc++.h>
+#include "bench_report.hpp"
+using namespace std;
+
+// ---------------------- Порівняння двох запусків бенчмарку ----------------------
+// Код повернення: 0 — регресій немає, 1 — є регресія, змінилися результати
+// або бенчмарк зник із поточного запуску, 2 — помилка аргументів чи файлів.
+
+static bool load(const char *path, vector<BenchResult> &results) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+    string error;
+    if (!read_bench_json(in, results, error)) {
+        cerr << path << ": " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    CompareOptions options;
+    vector<const char *> files;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threshold" && i + 1 < argc) options.threshold = atof(argv[++i]);
+        else if (arg == "--alpha" && i + 1 < argc) options.alpha = atof(argv[++i]);
+        else files.push_back(argv[i]);
+    }
+    if (files.size() != 2) {
+        cerr << "Usage: bench_compare <baseline.json> <current.json> [--threshold 0.05] [--alpha 0.01]\n";
+        return 2;
+    }
+
+    vector<BenchResult> base, current;
+    if (!load(files[0], base) || !load(files[1], current)) return 2;
+
+    vector<BenchComparison> cmp = compare_bench(base, current, options);
+    size_t regressions = 0, mismatches = 0, missing = 0, added = 0;
+
+    cout << left << setw(48) << "benchmark" << right << setw(12) << "base p50" << setw(12)
+         << "curr p50" << setw(10) << "change" << setw(10) << "p-value" << "  verdict\n";
+    for (const BenchComparison &c : cmp) {
+        string verdict = "ok";
+        if (c.missing) verdict = "MISSING", ++missing;
+        else if (c.added) verdict = "new", ++added;
+        else if (c.mismatch) verdict = "RESULT MISMATCH", ++mismatches;
+        else if (c.regression) verdict = "REGRESSION", ++regressions;
+        else if (c.improvement) verdict = "improved";
+        else if (fabs(c.change) > options.threshold) verdict = "noise";
+
+        cout << left << setw(48) << c.key << right << fixed << setprecision(1)
+             << setw(12) << c.base_p50 << setw(12) << c.current_p50
+             << setw(9) << c.change * 100 << "%" << setprecision(4) << setw(10) << c.p_value
+             << "  " << verdict << "\n";
+    }
+
+    cout << defaultfloat << setprecision(6);
+    cout << "\n" << cmp.size() - missing - added << " compared, " << regressions << " regressions, "
+         << mismatches << " result mismatches, " << missing << " missing, " << added
+         << " new (threshold " << options.threshold * 100
+         << "%, alpha " << options.alpha << ")\n";
+    return regressions || mismatches || missing ? 1 : 0;
+}
@@ -0,0 +1,395 @@
+#include "bench_report.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+using namespace std;
+
+/**
+ * @brief Створює порожній результат.
+ */
+BenchResult::BenchResult() : bytes(0), patterns(0), matches(0) {}
+
+/**
+ * @brief Ключ для зіставлення результатів.
+ * @return Рядок engine/dictionary/corpus.
+ */
+string BenchResult::key() const {
+    return engine + "/" + dictionary + "/" + corpus;
+}
+
+/**
+ * @brief Перцентиль з лінійною інтерполяцією між сусідніми елементами.
+ *
+ * @param samples Вибірка.
+ * @param q Рівень від 0 до 1.
+ * @return Значення перцентиля.
+ */
+double percentile(vector<double> samples, double q) {
+    if (samples.empty()) return 0;
+    sort(samples.begin(), samples.end());
+    double pos = q * (samples.size() - 1);
+    size_t lo = (size_t)pos;
+    size_t hi = min(lo + 1, samples.size() - 1);
+    return samples[lo] + (samples[hi] - samples[lo]) * (pos - lo);
+}
+
+// ---------------------- Запис JSON ----------------------
+
+/**
+ * @brief Записує рядок JSON з екрануванням.
+ * @param os Потік виводу.
+ * @param s Рядок.
+ */
+static void write_json_string(ostream &os, const string &s) {
+    os << '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') os << '\\' << c;
+        else if (c == '\n') os << "\\n";
+        else if (c < 0x20) os << "\\u" << hex << setw(4) << setfill('0') << (int)c << dec << setfill(' ');
+        else os << c;
+    }
+    os << '"';
+}
+
+/**
+ * @brief Записує результати бенчмарку у JSON.
+ * @param os Потік виводу.
+ * @param results Результати.
+ */
+void write_bench_json(ostream &os, const vector<BenchResult> &results) {
+    ios::fmtflags flags = os.flags();
+    streamsize precision = os.precision();
+    os << setprecision(10);
+    os << "{\n  \"version\": 1,\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        double p50 = percentile(r.samples_us, 0.5);
+        double mean = 0;
+        for (double x : r.samples_us) mean += x;
+        if (!r.samples_us.empty()) mean /= r.samples_us.size();
+
+        os << (i ? ",\n" : "\n") << "    {\"engine\": ";
+        write_json_string(os, r.engine);
+        os << ", \"dictionary\": ";
+        write_json_string(os, r.dictionary);
+        os << ", \"corpus\": ";
+        write_json_string(os, r.corpus);
+        os << ",\n     \"bytes\": " << r.bytes << ", \"patterns\": " << r.patterns
+           << ", \"matches\": " << r.matches
+           << ", \"throughput_mb_s\": " << (p50 > 0 ? r.bytes / p50 : 0) << ",\n"
+           << "     \"latency_us\": {\"min\": " << percentile(r.samples_us, 0)
+           << ", \"p50\": " << p50
+           << ", \"p90\": " << percentile(r.samples_us, 0.9)
+           << ", \"p99\": " << percentile(r.samples_us, 0.99)
+           << ", \"mean\": " << mean << "},\n     \"samples_us\": [";
+        for (size_t j = 0; j < r.samples_us.size(); ++j) os << (j ? ", " : "") << r.samples_us[j];
+        os << "],\n     \"counters\": {";
+        for (size_t j = 0; j < r.counters.size(); ++j) {
+            os << (j ? ", " : "");
+            write_json_string(os, r.counters[j].first);
+            os << ": " << r.counters[j].second;
+        }
+        os << "}}";
+    }
+    os << "\n  ]\n}\n";
+    os.flags(flags);
+    os.precision(precision);
+}
+
+// ---------------------- Читання JSON ----------------------
+
+/**
+ * @brief Мінімальне дерево значення JSON.
+ */
+struct JsonValue {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type = NUL;
+    double number = 0;
+    string str;
+    vector<JsonValue> items;
+    vector<pair<string, JsonValue>> fields;
+
+    const JsonValue *get(const string &name) const {
+        for (const auto &f : fields) {
+            if (f.first == name) return &f.second;
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * @brief Рекурсивний розбір JSON із позицією для повідомлень про помилки.
+ */
+struct JsonParser {
+    const string &src;
+    size_t pos;
+    string error;
+
+    explicit JsonParser(const string &s) : src(s), pos(0) {}
+
+    void skip_ws() {
+        while (pos < src.size() && isspace((unsigned char)src[pos])) ++pos;
+    }
+
+    bool fail(const string &what) {
+        if (error.empty()) error = what + " at offset " + to_string(pos);
+        return false;
+    }
+
+    bool parse_string(string &out) {
+        if (pos >= src.size() || src[pos] != '"') return fail("expected string");
+        ++pos;
+        while (pos < src.size() && src[pos] != '"') {
+            char c = src[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= src.size()) break;
+            char e = src[pos++];
+            switch (e) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                if (pos + 4 > src.size()) return fail("bad escape");
+                unsigned cp = (unsigned)strtoul(src.substr(pos, 4).c_str(), nullptr, 16);
+                pos += 4;
+                if (cp < 0x80) out += (char)cp;
+                else if (cp < 0x800) {
+                    out += (char)(0xC0 | (cp >> 6));
+                    out += (char)(0x80 | (cp & 0x3F));
+                } else {
+                    out += (char)(0xE0 | (cp >> 12));
+                    out += (char)(0x80 | ((cp >> 6) & 0x3F));
+                    out += (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: out += e;
+            }
+        }
+        if (pos >= src.size()) return fail("unterminated string");
+        ++pos;
+        return true;
+    }
+
+    bool parse_value(JsonValue &v) {
+        skip_ws();
+        if (pos >= src.size()) return fail("unexpected end");
+        char c = src[pos];
+        if (c == '{') {
+            v.type = JsonValue::OBJECT;
+            ++pos;
+            skip_ws();
+            if (pos < src.size() && src[pos] == '}') { ++pos; return true; }
+            while (true) {
+                skip_ws();
+                pair<string, JsonValue> field;
+                if (!parse_string(field.first)) return false;
+                skip_ws();
+                if (pos >= src.size() || src[pos] != ':') return fail("expected ':'");
+                ++pos;
+                if (!parse_value(field.second)) return false;
+                v.fields.push_back(move(field));
+                skip_ws();
+                if (pos < src.size() && src[pos] == ',') { ++pos; continue; }
+                if (pos < src.size() && src[pos] == '}') { ++pos; return true; }
+                return fail("expected ',' or '}'");
+            }
+        }
+        if (c == '[') {
+            v.type = JsonValue::ARRAY;
+            ++pos;
+            skip_ws();
+            if (pos < src.size() && src[pos] == ']') { ++pos; return true; }
+            while (true) {
+                JsonValue item;
+                if (!parse_value(item)) return false;
+                v.items.push_back(move(item));
+                skip_ws();
+                if (pos < src.size() && src[pos] == ',') { ++pos; continue; }
+                if (pos < src.size() && src[pos] == ']') { ++pos; return true; }
+                return fail("expected ',' or ']'");
+            }
+        }
+        if (c == '"') {
+            v.type = JsonValue::STRING;
+            return parse_string(v.str);
+        }
+        if (src.compare(pos, 4, "true") == 0 || src.compare(pos, 5, "false") == 0) {
+            v.type = JsonValue::BOOL;
+            v.number = src[pos] == 't';
+            pos += src[pos] == 't' ? 4 : 5;
+            return true;
+        }
+        if (src.compare(pos, 4, "null") == 0) {
+            pos += 4;
+            return true;
+        }
+        const char *begin = src.c_str() + pos;
+        char *end = nullptr;
+        v.number = strtod(begin, &end);
+        if (end == begin) return fail("unexpected character");
+        v.type = JsonValue::NUMBER;
+        pos += end - begin;
+        return true;
+    }
+};
+
+/**
+ * @brief Читає результати бенчмарку з JSON.
+ *
+ * Похідні поля (перцентилі, пропускна здатність) ігноруються: вони
+ * перераховуються з samples_us.
+ *
+ * @param is Потік вводу.
+ * @param results Прочитані результати.
+ * @param error Опис помилки.
+ * @return true у разі успіху.
+ */
+bool read_bench_json(istream &is, vector<BenchResult> &results, string &error) {
+    string text((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+    JsonParser parser(text);
+    JsonValue root;
+    if (!parser.parse_value(root)) {
+        error = parser.error;
+        return false;
+    }
+
+    const JsonValue *list = root.get("results");
+    if (root.type != JsonValue::OBJECT || !list || list->type != JsonValue::ARRAY) {
+        error = "missing \"results\" array";
+        return false;
+    }
+
+    results.clear();
+    for (const JsonValue &item : list->items) {
+        BenchResult r;
+        const JsonValue *f;
+        if ((f = item.get("engine"))) r.engine = f->str;
+        if ((f = item.get("dictionary"))) r.dictionary = f->str;
+        if ((f = item.get("corpus"))) r.corpus = f->str;
+        if ((f = item.get("bytes"))) r.bytes = (size_t)f->number;
+        if ((f = item.get("patterns"))) r.patterns = (size_t)f->number;
+        if ((f = item.get("matches"))) r.matches = (size_t)f->number;
+        if ((f = item.get("samples_us"))) {
+            for (const JsonValue &x : f->items) r.samples_us.push_back(x.number);
+        }
+        if ((f = item.get("counters"))) {
+            for (const auto &c : f->fields) r.counters.push_back({c.first, (uint64_t)c.second.number});
+        }
+        if (r.engine.empty()) {
+            error = "result without \"engine\"";
+            return false;
+        }
+        results.push_back(move(r));
+    }
+    return true;
+}
+
+// ---------------------- Порівняння запусків ----------------------
+
+/**
+ * @brief Пороги за замовчуванням.
+ */
+CompareOptions::CompareOptions() : threshold(0.05), alpha(0.01) {}
+
+/**
+ * @brief Односторонній U-тест Манна–Вітні.
+ *
+ * Нормальне наближення з поправкою на зв'язки та на неперервність.
+ *
+ * @param a Перша вибірка.
+ * @param b Друга вибірка.
+ * @return p-значення гіпотези «значення b більші за значення a».
+ */
+static double mann_whitney_greater(const vector<double> &a, const vector<double> &b) {
+    size_t n1 = a.size(), n2 = b.size();
+    if (n1 == 0 || n2 == 0) return 1.0;
+
+    vector<pair<double, int>> all;
+    for (double x : a) all.push_back({x, 0});
+    for (double x : b) all.push_back({x, 1});
+    sort(all.begin(), all.end());
+
+    size_t n = all.size();
+    double rank_b = 0, ties = 0;
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].first == all[i].first) ++j;
+        double avg_rank = (i + 1 + j) / 2.0;
+        double t = (double)(j - i);
+        ties += t * t * t - t;
+        for (size_t k = i; k < j; ++k) {
+            if (all[k].second == 1) rank_b += avg_rank;
+        }
+        i = j;
+    }
+
+    double u = rank_b - n2 * (n2 + 1) / 2.0;
+    double mean = n1 * n2 / 2.0;
+    double var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1.0)));
+    if (var <= 0) return 1.0;
+    double z = (u - mean - 0.5) / sqrt(var);
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+/**
+ * @brief Порівнює два запуски бенчмарку.
+ *
+ * @param base Базовий запуск.
+ * @param current Поточний запуск.
+ * @param options Пороги.
+ * @return Порівняння для всіх ключів; ключі лише одного запуску позначено.
+ */
+vector<BenchComparison> compare_bench(const vector<BenchResult> &base,
+                                      const vector<BenchResult> &current,
+                                      const CompareOptions &options) {
+    map<string, const BenchResult *> by_key;
+    for (const BenchResult &r : base) by_key[r.key()] = &r;
+    set<string> seen;
+
+    vector<BenchComparison> out;
+    for (const BenchResult &cur : current) {
+        BenchComparison c = {};
+        c.key = cur.key();
+        c.current_p50 = percentile(cur.samples_us, 0.5);
+        c.p_value = 1.0;
+        seen.insert(c.key);
+
+        auto it = by_key.find(c.key);
+        if (it == by_key.end()) {
+            c.added = true;
+            out.push_back(c);
+            continue;
+        }
+        const BenchResult &old = *it->second;
+
+        c.base_p50 = percentile(old.samples_us, 0.5);
+        c.change = c.base_p50 > 0 ? c.current_p50 / c.base_p50 - 1.0 : 0.0;
+        c.p_value = mann_whitney_greater(old.samples_us, cur.samples_us);
+        double p_faster = mann_whitney_greater(cur.samples_us, old.samples_us);
+        c.regression = c.change > options.threshold && c.p_value < options.alpha;
+        c.improvement = -c.change > options.threshold && p_faster < options.alpha;
+        c.mismatch = old.matches != cur.matches || old.bytes != cur.bytes;
+        out.push_back(c);
+    }
+
+    for (const BenchResult &old : base) {
+        BenchComparison c = {};
+        c.key = old.key();
+        if (!seen.insert(c.key).second) continue;
+        c.base_p50 = percentile(old.samples_us, 0.5);
+        c.p_value = 1.0;
+        c.missing = true;
+        out.push_back(c);
+    }
+    return out;
+}
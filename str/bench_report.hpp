@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Результат одного вимірювання бенчмарку (рушій × словник × корпус).
+ */
+struct BenchResult {
+    std::string engine;              ///< Назва рушія пошуку.
+    std::string dictionary;          ///< Назва словника.
+    std::string corpus;              ///< Назва корпусу.
+    size_t bytes;                    ///< Розмір корпусу в байтах.
+    size_t patterns;                 ///< Кількість шаблонів.
+    size_t matches;                  ///< Загальна кількість збігів.
+    std::vector<double> samples_us;  ///< Час кожної ітерації в мікросекундах.
+    std::vector<std::pair<std::string, uint64_t>> counters; ///< Апаратні лічильники (назва, значення).
+
+    /**
+     * @brief Створює порожній результат.
+     */
+    BenchResult();
+
+    /**
+     * @brief Повертає ключ для зіставлення результатів двох запусків.
+     * @return Рядок вигляду engine/dictionary/corpus.
+     */
+    std::string key() const;
+};
+
+/**
+ * @brief Обчислює перцентиль вибірки з лінійною інтерполяцією.
+ *
+ * @param samples Вибірка (може бути невпорядкованою).
+ * @param q Рівень від 0 до 1 (0.5 — медіана).
+ * @return Значення перцентиля або 0 для порожньої вибірки.
+ */
+double percentile(std::vector<double> samples, double q);
+
+/**
+ * @brief Записує результати у форматі JSON.
+ *
+ * Окрім сирих вибірок записує похідні поля (пропускна здатність за медіаною,
+ * min/p50/p90/p99/mean), щоб файл можна було читати й іншими інструментами.
+ *
+ * @param os Потік виводу.
+ * @param results Результати.
+ */
+void write_bench_json(std::ostream &os, const std::vector<BenchResult> &results);
+
+/**
+ * @brief Читає результати з JSON, записаного write_bench_json.
+ *
+ * @param is Потік вводу.
+ * @param results Сюди записуються прочитані результати.
+ * @param error Опис помилки, якщо читання не вдалося.
+ * @return true, якщо файл прочитано успішно.
+ */
+bool read_bench_json(std::istream &is, std::vector<BenchResult> &results, std::string &error);
+
+/**
+ * @brief Пороги для порівняння двох запусків.
+ */
+struct CompareOptions {
+    double threshold; ///< Мінімальне відносне сповільнення медіани, що вважається регресією.
+    double alpha;     ///< Рівень значущості одностороннього тесту Манна–Вітні.
+
+    /**
+     * @brief Пороги за замовчуванням: 5% і alpha = 0.01.
+     */
+    CompareOptions();
+};
+
+/**
+ * @brief Результат порівняння одного ключа між базовим і поточним запуском.
+ */
+struct BenchComparison {
+    std::string key;     ///< Ключ engine/dictionary/corpus.
+    double base_p50;     ///< Медіана базового запуску (мкс).
+    double current_p50;  ///< Медіана поточного запуску (мкс).
+    double change;       ///< Відносна зміна медіани (0.1 — на 10% повільніше).
+    double p_value;      ///< p-значення гіпотези «поточний повільніший».
+    bool regression;     ///< Статистично значуще сповільнення понад поріг.
+    bool improvement;    ///< Статистично значуще пришвидшення понад поріг.
+    bool mismatch;       ///< Різна кількість збігів — результати пошуку змінилися.
+    bool missing;        ///< Ключ є лише в базовому запуску (current_p50 = 0).
+    bool added;          ///< Ключ є лише в поточному запуску (base_p50 = 0).
+};
+
+/**
+ * @brief Порівнює два запуски бенчмарку.
+ *
+ * Для кожного ключа, наявного в обох запусках, медіани порівнюються з
+ * порогом threshold, а значущість перевіряється одностороннім U-тестом
+ * Манна–Вітні (нормальне наближення з поправкою на зв'язки). Регресією
+ * вважається лише зміна, що одночасно перевищує поріг і значуща, тож шум
+ * окремих ітерацій не спрацьовує як регресія.
+ *
+ * Ключі, наявні лише в одному із запусків, не відкидаються: вони
+ * повертаються з позначкою added (новий бенчмарк) або missing (бенчмарк
+ * зник із поточного запуску) без статистики.
+ *
+ * @param base Базовий запуск.
+ * @param current Поточний запуск.
+ * @param options Пороги.
+ * @return Порівняння в порядку поточного запуску, за ним — зниклі ключі
+ *         в порядку базового.
+ */
+std::vector<BenchComparison> compare_bench(const std::vector<BenchResult> &base,
+                                           const std::vector<BenchResult> &current,
+                                           const CompareOptions &options);
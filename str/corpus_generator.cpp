@@ -0,0 +1,247 @@
+#include "corpus_generator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+using namespace std;
+
+/**
+ * @brief Створює генератор splitmix64.
+ * @param seed Початкове значення.
+ */
+CorpusRng::CorpusRng(uint64_t seed) : state(seed) {}
+
+/**
+ * @brief Наступне число splitmix64.
+ * @return Псевдовипадкове число.
+ */
+uint64_t CorpusRng::next() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Число з діапазону [0, n).
+ *
+ * Зсув через остачу для n, набагато менших за 2^64, нехтовно малий.
+ *
+ * @param n Верхня межа.
+ * @return Псевдовипадкове число.
+ */
+uint64_t CorpusRng::below(uint64_t n) {
+    return next() % n;
+}
+
+/**
+ * @brief Дійсне число з [0, 1) зі старших 53 бітів.
+ * @return Псевдовипадкове число.
+ */
+double CorpusRng::uniform() {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Генерує одне слово зі складів.
+ *
+ * @param rng Генератор.
+ * @param syllables Кількість складів.
+ * @return Слово.
+ */
+static string make_word(CorpusRng &rng, size_t syllables) {
+    static const char consonants[] = "tnshrdlcmwfgypbvk";
+    static const char vowels[] = "eaoiu";
+    string w;
+    for (size_t i = 0; i < syllables; ++i) {
+        w += consonants[rng.below(sizeof(consonants) - 1)];
+        w += vowels[rng.below(sizeof(vowels) - 1)];
+        if (rng.below(4) == 0) w += consonants[rng.below(sizeof(consonants) - 1)];
+    }
+    return w;
+}
+
+/**
+ * @brief Словник «англоподібних» слів.
+ *
+ * @param n Кількість слів.
+ * @param seed Початкове значення генератора.
+ * @return Унікальні слова.
+ */
+vector<string> english_like_words(size_t n, uint64_t seed) {
+    CorpusRng rng(seed);
+    vector<string> words;
+    unordered_set<string> seen;
+    words.reserve(n);
+
+    while (words.size() < n) {
+        string w = make_word(rng, 1 + rng.below(4));
+        if (w.size() > 12) w.resize(12);
+        if (seen.insert(w).second) words.push_back(w);
+    }
+    return words;
+}
+
+/**
+ * @brief Дописує роздільник після слова.
+ *
+ * Після кожного ~12-го слова — новий рядок, зрідка кома чи крапка.
+ *
+ * @param rng Генератор.
+ * @param out Текст, що генерується.
+ */
+static void append_separator(CorpusRng &rng, string &out) {
+    uint64_t r = rng.below(100);
+    if (r < 8) out += '\n';
+    else if (r < 12) out += ", ";
+    else if (r < 14) out += ". ";
+    else out += ' ';
+}
+
+/**
+ * @brief Потік слів за законом Ципфа.
+ *
+ * Ранг обирається бінарним пошуком у кумулятивному розподілі.
+ *
+ * @param bytes Розмір тексту.
+ * @param vocabulary Словник у порядку рангу.
+ * @param exponent Показник закону Ципфа.
+ * @param seed Початкове значення генератора.
+ * @return Текст.
+ */
+string zipf_text(size_t bytes, const vector<string> &vocabulary, double exponent, uint64_t seed) {
+    string out;
+    if (vocabulary.empty()) return string(bytes, ' ');
+
+    vector<double> cdf(vocabulary.size());
+    double sum = 0;
+    for (size_t r = 0; r < vocabulary.size(); ++r) {
+        sum += 1.0 / pow((double)(r + 1), exponent);
+        cdf[r] = sum;
+    }
+
+    CorpusRng rng(seed);
+    out.reserve(bytes + 32);
+    while (out.size() < bytes) {
+        double u = rng.uniform() * sum;
+        size_t r = lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+        if (r >= vocabulary.size()) r = vocabulary.size() - 1;
+        out += vocabulary[r];
+        append_separator(rng, out);
+    }
+    out.resize(bytes);
+    return out;
+}
+
+/**
+ * @brief Випадкові байти.
+ *
+ * @param bytes Розмір тексту.
+ * @param seed Початкове значення генератора.
+ * @return Текст.
+ */
+string random_bytes(size_t bytes, uint64_t seed) {
+    CorpusRng rng(seed);
+    string out(bytes, '\0');
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t r = rng.next();
+        for (int b = 0; b < 8; ++b) out[i + b] = (char)(r >> (8 * b));
+    }
+    uint64_t r = rng.next();
+    for (; i < bytes; ++i, r >>= 8) out[i] = (char)r;
+    return out;
+}
+
+/**
+ * @brief Текст із високою щільністю збігів.
+ *
+ * @param bytes Розмір тексту.
+ * @param patterns Шаблони для вставки.
+ * @param density Частка слів-шаблонів.
+ * @param seed Початкове значення генератора.
+ * @return Текст.
+ */
+string dense_text(size_t bytes, const vector<string> &patterns, double density, uint64_t seed) {
+    CorpusRng rng(seed);
+    string out;
+    out.reserve(bytes + 32);
+
+    while (out.size() < bytes) {
+        if (!patterns.empty() && rng.uniform() < density) {
+            out += patterns[rng.below(patterns.size())];
+        } else {
+            size_t len = 2 + rng.below(8);
+            for (size_t i = 0; i < len; ++i) out += (char)('a' + rng.below(26));
+        }
+        append_separator(rng, out);
+    }
+    out.resize(bytes);
+    return out;
+}
+
+/**
+ * @brief Словник зі спільним префіксом.
+ *
+ * @param n Кількість слів.
+ * @param prefix_len Довжина спільного префікса.
+ * @param seed Початкове значення генератора.
+ * @return Словник.
+ */
+vector<string> shared_prefix_dictionary(size_t n, size_t prefix_len, uint64_t seed) {
+    CorpusRng rng(seed);
+    string prefix;
+    for (size_t i = 0; i < prefix_len; ++i) prefix += (char)('a' + rng.below(26));
+
+    vector<string> words;
+    words.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        string w = prefix;
+        // унікальний хвіст: номер слова в системі числення з основою 26
+        size_t x = i;
+        do {
+            w += (char)('a' + x % 26);
+            x /= 26;
+        } while (x > 0);
+        w += (char)('a' + rng.below(26));
+        words.push_back(w);
+    }
+    return words;
+}
+
+/**
+ * @brief Словник-ланцюжок суфіксів.
+ *
+ * @param n Кількість слів.
+ * @param c Символ слів.
+ * @return Словник.
+ */
+vector<string> suffix_chain_dictionary(size_t n, char c) {
+    vector<string> words;
+    words.reserve(n);
+    for (size_t i = 1; i <= n; ++i) words.push_back(string(i, c));
+    return words;
+}
+
+/**
+ * @brief Словник випадкових слів.
+ *
+ * @param n Кількість слів.
+ * @param min_len Мінімальна довжина.
+ * @param max_len Максимальна довжина.
+ * @param seed Початкове значення генератора.
+ * @return Словник.
+ */
+vector<string> random_word_dictionary(size_t n, size_t min_len, size_t max_len, uint64_t seed) {
+    CorpusRng rng(seed);
+    if (max_len < min_len) max_len = min_len;
+
+    vector<string> words;
+    words.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        size_t len = min_len + rng.below(max_len - min_len + 1);
+        string w(len, 'a');
+        for (char &ch : w) ch = (char)('a' + rng.below(26));
+        words.push_back(w);
+    }
+    return words;
+}
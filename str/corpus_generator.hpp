@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Детермінований генератор псевдовипадкових чисел (splitmix64).
+ *
+ * Використовується замість стандартних розподілів, результат яких може
+ * відрізнятися між реалізаціями бібліотеки: той самий seed дає той самий
+ * корпус на будь-якій платформі.
+ */
+struct CorpusRng {
+    uint64_t state; ///< Поточний стан генератора.
+
+    /**
+     * @brief Створює генератор із заданим seed.
+     * @param seed Початкове значення.
+     */
+    explicit CorpusRng(uint64_t seed);
+
+    /**
+     * @brief Повертає наступне 64-бітне число.
+     * @return Псевдовипадкове число.
+     */
+    uint64_t next();
+
+    /**
+     * @brief Повертає число з діапазону [0, n).
+     * @param n Верхня межа (більша за 0).
+     * @return Псевдовипадкове число.
+     */
+    uint64_t below(uint64_t n);
+
+    /**
+     * @brief Повертає дійсне число з діапазону [0, 1).
+     * @return Псевдовипадкове число.
+     */
+    double uniform();
+};
+
+/**
+ * @brief Створює словник «англоподібних» слів зі складів приголосна+голосна.
+ *
+ * Слова унікальні, довжиною від 2 до 12 літер; порядок слів відповідає
+ * їхньому рангу в zipf_text (перше слово — найчастіше).
+ *
+ * @param n Кількість слів.
+ * @param seed Початкове значення генератора.
+ * @return Словник слів.
+ */
+std::vector<std::string> english_like_words(size_t n, uint64_t seed);
+
+/**
+ * @brief Генерує потік слів із розподілом частот за законом Ципфа.
+ *
+ * Слово рангу r зустрічається з імовірністю, пропорційною 1 / r^exponent.
+ * Слова розділяються пробілами, зрідка розділовими знаками, а кожні
+ * кілька слів починається новий рядок, як у журналах.
+ *
+ * @param bytes Розмір тексту в байтах.
+ * @param vocabulary Словник у порядку рангу (див. english_like_words).
+ * @param exponent Показник закону Ципфа.
+ * @param seed Початкове значення генератора.
+ * @return Згенерований текст рівно з bytes байтів.
+ */
+std::string zipf_text(size_t bytes, const std::vector<std::string> &vocabulary,
+                      double exponent, uint64_t seed);
+
+/**
+ * @brief Генерує випадкові байти (усі 256 значень рівноймовірні).
+ *
+ * @param bytes Розмір тексту в байтах.
+ * @param seed Початкове значення генератора.
+ * @return Згенерований текст.
+ */
+std::string random_bytes(size_t bytes, uint64_t seed);
+
+/**
+ * @brief Генерує текст із високою щільністю збігів.
+ *
+ * Кожне слово з імовірністю density береться зі словника шаблонів,
+ * інакше — випадкове слово з малих літер.
+ *
+ * @param bytes Розмір тексту в байтах.
+ * @param patterns Шаблони, які вставляються в текст.
+ * @param density Частка слів-шаблонів від 0 до 1.
+ * @param seed Початкове значення генератора.
+ * @return Згенерований текст рівно з bytes байтів.
+ */
+std::string dense_text(size_t bytes, const std::vector<std::string> &patterns,
+                       double density, uint64_t seed);
+
+/**
+ * @brief Словник зі спільним довгим префіксом (глибокий вузький бор).
+ *
+ * Усі слова мають спільний префікс довжини prefix_len, після якого йде
+ * унікальний випадковий хвіст.
+ *
+ * @param n Кількість слів.
+ * @param prefix_len Довжина спільного префікса.
+ * @param seed Початкове значення генератора.
+ * @return Словник.
+ */
+std::vector<std::string> shared_prefix_dictionary(size_t n, size_t prefix_len, uint64_t seed);
+
+/**
+ * @brief Словник-ланцюжок суфіксів: "a", "aa", "aaa", ...
+ *
+ * На тексті з повторів того самого символу кожна позиція закінчує
+ * всі коротші шаблони, тож кількість збігів зростає квадратично.
+ *
+ * @param n Кількість слів (довжина найдовшого).
+ * @param c Символ, з якого складаються слова.
+ * @return Словник.
+ */
+std::vector<std::string> suffix_chain_dictionary(size_t n, char c);
+
+/**
+ * @brief Словник із випадкових слів з малих латинських літер.
+ *
+ * @param n Кількість слів.
+ * @param min_len Мінімальна довжина слова.
+ * @param max_len Максимальна довжина слова.
+ * @param seed Початкове значення генератора.
+ * @return Словник (слова можуть повторюватися).
+ */
+std::vector<std::string> random_word_dictionary(size_t n, size_t min_len, size_t max_len,
+                                                uint64_t seed);
@@ -0,0 +1,99 @@
+#include <bits/stdc++.h>
+#include "corpus_generator.hpp"
+using namespace std;
+
+// ---------------------- Генератор корпусів і словників ----------------------
+// Результат пишеться у stdout; однаковий seed дає однаковий результат.
+
+static const uint64_t DEFAULT_SEED = 42;
+static const size_t ZIPF_VOCABULARY = 50000; // розмір словника для zipf-тексту
+static const double ZIPF_EXPONENT = 1.07;    // близько до частот англійських слів
+static const size_t PREFIX_LEN = 32;         // спільний префікс словника prefix
+
+static void usage() {
+    cerr << "Usage:\n"
+         << "  gen_corpus zipf    <bytes> [seed]                      English-like Zipfian word stream\n"
+         << "  gen_corpus random  <bytes> [seed]                      uniformly random bytes\n"
+         << "  gen_corpus dense   <bytes> <dict-file> [density] [seed] text dense with dictionary words\n"
+         << "  gen_corpus english <count> [seed]                      dictionary of English-like words\n"
+         << "  gen_corpus prefix  <count> [seed]                      dictionary with a deep shared prefix\n"
+         << "  gen_corpus suffix  <count>                             dictionary a, aa, aaa, ...\n"
+         << "  gen_corpus words   <count> [seed]                      dictionary of random 3..12 letter words\n";
+}
+
+static bool parse_u64(const char *s, uint64_t &out) {
+    char *end = nullptr;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 10);
+    if (errno != 0 || end == s || *end != '\0') return false;
+    out = v;
+    return true;
+}
+
+static bool read_dictionary(const char *path, vector<string> &patterns) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty()) patterns.push_back(line);
+    }
+    return true;
+}
+
+static void print_dictionary(const vector<string> &words) {
+    for (const string &w : words) cout << w << '\n';
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+
+    string kind = argv[1];
+    uint64_t size = 0;
+    if (!parse_u64(argv[2], size)) {
+        cerr << "Invalid size: " << argv[2] << "\n";
+        return 2;
+    }
+
+    // необов'язковий seed — останній аргумент після обов'язкових
+    auto seed_at = [&](int idx) {
+        uint64_t seed = DEFAULT_SEED;
+        if (argc > idx && !parse_u64(argv[idx], seed)) {
+            cerr << "Invalid seed: " << argv[idx] << "\n";
+            exit(2);
+        }
+        return seed;
+    };
+
+    ios::sync_with_stdio(false);
+
+    if (kind == "zipf") {
+        uint64_t seed = seed_at(3);
+        cout << zipf_text(size, english_like_words(ZIPF_VOCABULARY, seed), ZIPF_EXPONENT, seed);
+    } else if (kind == "random") {
+        cout << random_bytes(size, seed_at(3));
+    } else if (kind == "dense") {
+        vector<string> patterns;
+        if (argc < 4 || !read_dictionary(argv[3], patterns)) {
+            cerr << "Cannot read dictionary file\n";
+            return 2;
+        }
+        double density = argc > 4 ? atof(argv[4]) : 0.5;
+        cout << dense_text(size, patterns, density, seed_at(5));
+    } else if (kind == "english") {
+        print_dictionary(english_like_words(size, seed_at(3)));
+    } else if (kind == "prefix") {
+        print_dictionary(shared_prefix_dictionary(size, PREFIX_LEN, seed_at(3)));
+    } else if (kind == "suffix") {
+        print_dictionary(suffix_chain_dictionary(size, 'a'));
+    } else if (kind == "words") {
+        print_dictionary(random_word_dictionary(size, 3, 12, seed_at(3)));
+    } else {
+        usage();
+        return 2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <bits/stdc++.h>
+#include <csignal>
+#include <unistd.h>
+#include "match_server.hpp"
+using namespace std;
+
+// ---------------------- Демон пошуку ----------------------
+// Завантажує словники один раз і відповідає на запити через Unix-сокет
+// (протокол див. у match_server.hpp). Режим --query — простий клієнт:
+// текст читається зі stdin, лічильники друкуються в stdout.
+
+static MatchServer *running = nullptr;
+
+static void on_signal(int) {
+    if (running) running->stop();
+}
+
+static void usage() {
+    cerr << "Usage:\n"
+         << "  match_daemon <socket> <dict-file>... [--threads N]   serve dictionaries (index = order)\n"
+         << "  match_daemon --query <socket> <dict-index>           match stdin against a dictionary\n";
+}
+
+static bool read_dictionary(const char *path, vector<string> &patterns) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty()) patterns.push_back(line);
+    }
+    return true;
+}
+
+static int query(const char *socket_path, const char *dictionary) {
+    int fd = match_connect(socket_path);
+    if (fd < 0) {
+        cerr << "Cannot connect to " << socket_path << "\n";
+        return 1;
+    }
+    string text((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+
+    MatchReply reply;
+    bool ok = match_request(fd, (uint32_t)strtoul(dictionary, nullptr, 10), text, reply);
+    close(fd);
+    if (!ok) {
+        cerr << "Connection failed\n";
+        return 1;
+    }
+    if (reply.status != MATCH_OK) {
+        cerr << "Request failed with status " << reply.status << "\n";
+        return 1;
+    }
+    cout << "total " << reply.total << "\n";
+    for (const MatchCount &c : reply.counts) cout << c.pattern << " " << c.count << "\n";
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && string(argv[1]) == "--query") return query(argv[2], argv[3]);
+
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    vector<const char *> args;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) threads = (unsigned)max(1, atoi(argv[++i]));
+        else args.push_back(argv[i]);
+    }
+    if (args.size() < 2) {
+        usage();
+        return 2;
+    }
+
+    MatchServer server(threads);
+    for (size_t i = 1; i < args.size(); ++i) {
+        vector<string> patterns;
+        if (!read_dictionary(args[i], patterns)) {
+            cerr << "Cannot read " << args[i] << "\n";
+            return 2;
+        }
+        server.dictionaries.emplace_back();
+        server.dictionaries.back().build_automaton(patterns);
+        cerr << "dictionary " << i - 1 << ": " << args[i] << " (" << patterns.size() << " patterns)\n";
+    }
+
+    if (!server.listen(args[0])) {
+        cerr << "Cannot listen on " << args[0] << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+    running = &server;
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    cerr << "listening on " << args[0] << " with " << threads << " threads\n";
+    server.run();
+    running = nullptr;
+
+    cerr << "served " << server.requests << " requests in " << server.batches << " batches\n";
+    return 0;
+}
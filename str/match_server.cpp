@@ -0,0 +1,407 @@
+#include "match_server.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+using namespace std;
+
+/**
+ * @brief Стан одного клієнтського з'єднання.
+ */
+struct Connection {
+    int fd;              ///< Сокет клієнта.
+    RequestHeader header; ///< Заголовок поточного запиту.
+    size_t header_got;   ///< Скільки байтів заголовка вже прочитано.
+    string text;         ///< Буфер тексту, у якому виконується пошук (перевикористовується).
+    size_t text_got;     ///< Скільки байтів тексту вже прочитано.
+    bool ready;          ///< Запит повністю прочитано.
+    bool closing;        ///< Закрити з'єднання після відповіді.
+    uint32_t status;     ///< Стан запиту до пошуку.
+    SparseCounts hits;   ///< Результат пошуку (перевикористовується).
+    string reply;        ///< Закодована відповідь.
+    size_t reply_sent;   ///< Скільки байтів відповіді вже надіслано.
+    bool sending;        ///< Відповідь ще не надіслано повністю; нові запити не читаються.
+
+    explicit Connection(int fd_)
+        : fd(fd_), header(), header_got(0), text_got(0), ready(false), closing(false), status(MATCH_OK),
+          reply_sent(0), sending(false) {}
+};
+
+/**
+ * @brief Надсилає всі байти, чекаючи на готовність сокета за потреби.
+ * @param fd Сокет.
+ * @param data Дані.
+ * @param size Розмір.
+ * @return true, якщо все надіслано.
+ */
+static bool send_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n > 0) {
+            data += n;
+            size -= (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd p = {fd, POLLOUT, 0};
+            poll(&p, 1, -1);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Надсилає решту відповіді, скільки приймає сокет, без очікування.
+ *
+ * Коли відповідь надіслано повністю, з'єднання готове до наступного запиту.
+ *
+ * @param conn З'єднання з відповіддю.
+ * @return false, якщо сталася помилка (з'єднання треба закрити).
+ */
+static bool flush_reply(Connection &conn) {
+    while (conn.reply_sent < conn.reply.size()) {
+        ssize_t n = send(conn.fd, conn.reply.data() + conn.reply_sent, conn.reply.size() - conn.reply_sent,
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.reply_sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            conn.sending = true;
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    conn.sending = false;
+    conn.ready = false;
+    conn.header_got = 0;
+    conn.text_got = 0;
+    conn.status = MATCH_OK;
+    return true;
+}
+
+/**
+ * @brief Читає рівно size байтів із блокуючого сокета.
+ * @param fd Сокет.
+ * @param data Буфер.
+ * @param size Розмір.
+ * @return true, якщо все прочитано.
+ */
+static bool recv_all(int fd, char *data, size_t size) {
+    while (size > 0) {
+        ssize_t n = recv(fd, data, size, 0);
+        if (n > 0) {
+            data += n;
+            size -= (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Дочитує поточний запит з'єднання, скільки дозволяє сокет.
+ *
+ * Текст читається безпосередньо в conn.text. Буфер росте в міру
+ * надходження даних (починаючи з READ_CHUNK і подвоюючись), тож заголовок
+ * без тексту не змушує виділяти пам'ять під усю заявлену довжину.
+ * Наступний запит не читається, доки на поточний не надіслано відповідь.
+ *
+ * @param conn З'єднання.
+ * @return false, якщо клієнт закрив з'єднання або сталася помилка.
+ */
+static bool read_request(Connection &conn) {
+    const size_t READ_CHUNK = 64 << 10;
+    while (!conn.ready) {
+        char *dst;
+        size_t want;
+        if (conn.header_got < sizeof(RequestHeader)) {
+            dst = reinterpret_cast<char *>(&conn.header) + conn.header_got;
+            want = sizeof(RequestHeader) - conn.header_got;
+        } else {
+            // буфер подвоюється, але не більше, ніж лишилося прочитати
+            if (conn.text_got == conn.text.size()) {
+                size_t grow = max(conn.text.size(), READ_CHUNK);
+                conn.text.resize(conn.text_got + min<size_t>(conn.header.length - conn.text_got, grow));
+            }
+            dst = &conn.text[conn.text_got];
+            want = conn.text.size() - conn.text_got;
+        }
+
+        ssize_t n = recv(conn.fd, dst, want, 0);
+        if (n == 0) return false;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        if (conn.header_got < sizeof(RequestHeader)) {
+            conn.header_got += (size_t)n;
+            if (conn.header_got < sizeof(RequestHeader)) continue;
+
+            if (conn.header.magic != REQUEST_MAGIC) {
+                conn.status = MATCH_BAD_REQUEST;
+                conn.closing = true;
+                conn.ready = true;
+            } else if (conn.header.length > MAX_REQUEST_BYTES) {
+                conn.status = MATCH_TOO_LARGE;
+                conn.closing = true;
+                conn.ready = true;
+            } else {
+                conn.text.clear();
+                conn.text_got = 0;
+                conn.ready = conn.header.length == 0;
+            }
+        } else {
+            conn.text_got += (size_t)n;
+            conn.ready = conn.text_got == conn.header.length;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Виконує пошук для готового запиту та кодує відповідь.
+ * @param server Сервер зі словниками.
+ * @param conn З'єднання з прочитаним запитом.
+ */
+static void answer(const MatchServer &server, Connection &conn) {
+    ResponseHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = RESPONSE_MAGIC;
+    h.status = conn.status;
+
+    if (h.status == MATCH_OK && conn.header.dictionary >= server.dictionaries.size()) {
+        h.status = MATCH_UNKNOWN_DICTIONARY;
+    }
+    if (h.status == MATCH_OK) {
+        h.total = server.dictionaries[conn.header.dictionary].search(conn.text, conn.hits);
+        h.pairs = (uint32_t)conn.hits.touched.size();
+    }
+
+    conn.reply.resize(sizeof(h) + (size_t)h.pairs * sizeof(MatchCount));
+    memcpy(&conn.reply[0], &h, sizeof(h));
+    MatchCount *pairs = reinterpret_cast<MatchCount *>(&conn.reply[sizeof(h)]);
+    for (uint32_t i = 0; i < h.pairs; ++i) {
+        int idx = conn.hits.touched[i];
+        size_t count = conn.hits.counts[idx];
+        pairs[i].pattern = (uint32_t)idx;
+        pairs[i].count = count > UINT32_MAX ? UINT32_MAX : (uint32_t)count;
+    }
+}
+
+/**
+ * @brief Створює сервер без словників.
+ * @param threads_ Потоки для обробки пакета.
+ */
+MatchServer::MatchServer(unsigned threads_)
+    : threads(threads_ ? threads_ : 1), listen_fd(-1), batches(0), requests(0) {
+    wake_pipe[0] = wake_pipe[1] = -1;
+}
+
+/**
+ * @brief Закриває сокет і видаляє його файл.
+ */
+MatchServer::~MatchServer() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(path.c_str());
+    }
+    if (wake_pipe[0] >= 0) close(wake_pipe[0]);
+    if (wake_pipe[1] >= 0) close(wake_pipe[1]);
+}
+
+/**
+ * @brief Створює слухаючий сокет.
+ * @param socket_path Шлях сокета.
+ * @return true, якщо сокет готовий.
+ */
+bool MatchServer::listen(const string &socket_path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) return false;
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    if (pipe(wake_pipe) != 0) return false;
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) return false;
+
+    unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd, 128) != 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    path = socket_path;
+    return true;
+}
+
+/**
+ * @brief Просить цикл подій завершитися.
+ */
+void MatchServer::stop() {
+    char c = 0;
+    if (wake_pipe[1] >= 0 && write(wake_pipe[1], &c, 1) < 0) {
+        // канал переповнений — цикл і так прокинеться
+    }
+}
+
+/**
+ * @brief Цикл подій.
+ *
+ * Кожна ітерація: poll по всіх з'єднаннях (POLLIN для тих, що чекають на
+ * запит, POLLOUT для тих, що мають ненадіслану відповідь); прийом нових
+ * з'єднань; дочитування запитів і дописування відповідей; пакетна обробка
+ * готових запитів. Відповідь надсилається без блокування: те, що сокет не
+ * прийняв, лишається в з'єднанні до наступного POLLOUT, тож клієнт, що не
+ * читає відповідей, не затримує інших.
+ */
+void MatchServer::run() {
+    vector<unique_ptr<Connection>> conns;
+    vector<pollfd> fds;
+    vector<Connection *> batch;
+
+    for (;;) {
+        fds.clear();
+        fds.push_back({wake_pipe[0], POLLIN, 0});
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const unique_ptr<Connection> &c : conns) {
+            fds.push_back({c->fd, (short)(c->sending ? POLLOUT : POLLIN), 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents) break;
+
+        // дописуємо відповіді й дочитуємо запити; з'єднання, закриті
+        // клієнтом або з помилкою, видаляються
+        batch.clear();
+        size_t kept = 0;
+        for (size_t i = 0; i < conns.size(); ++i) {
+            Connection &c = *conns[i];
+            bool alive = true;
+            if (fds[i + 2].revents) {
+                if (c.sending) {
+                    alive = flush_reply(c) && !(c.closing && !c.sending);
+                } else {
+                    alive = read_request(c);
+                }
+            }
+            if (!alive) {
+                close(c.fd);
+                continue;
+            }
+            if (c.ready && !c.sending) batch.push_back(&c);
+            conns[kept++] = move(conns[i]);
+        }
+        conns.resize(kept);
+
+        if (fds[1].revents) {
+            for (;;) {
+                int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) break;
+                conns.emplace_back(new Connection(fd));
+            }
+        }
+        if (batch.empty()) continue;
+
+        // пакет: пошук паралельно, потоки беруть запити через один
+        size_t workers = min<size_t>(threads, batch.size());
+        if (workers <= 1) {
+            for (Connection *c : batch) answer(*this, *c);
+        } else {
+            vector<thread> pool;
+            for (size_t w = 0; w < workers; ++w) {
+                pool.emplace_back([&, w] {
+                    for (size_t i = w; i < batch.size(); i += workers) answer(*this, *batch[i]);
+                });
+            }
+            for (thread &t : pool) t.join();
+        }
+        ++batches;
+        requests += batch.size();
+
+        for (Connection *c : batch) {
+            c->reply_sent = 0;
+            if (!flush_reply(*c)) {
+                c->sending = false;
+                c->closing = true;
+            }
+        }
+        kept = 0;
+        for (size_t i = 0; i < conns.size(); ++i) {
+            // з'єднання, що закривається, живе, доки відповідь не надіслано
+            if (conns[i]->closing && !conns[i]->sending) {
+                close(conns[i]->fd);
+                continue;
+            }
+            conns[kept++] = move(conns[i]);
+        }
+        conns.resize(kept);
+    }
+
+    for (const unique_ptr<Connection> &c : conns) close(c->fd);
+}
+
+/**
+ * @brief Під'єднується до сервера.
+ * @param socket_path Шлях сокета.
+ * @return Дескриптор або -1.
+ */
+int match_connect(const string &socket_path) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) return -1;
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Надсилає запит і чекає на відповідь.
+ * @param fd Під'єднаний сокет.
+ * @param dictionary Індекс словника.
+ * @param text Текст для пошуку.
+ * @param reply Відповідь сервера.
+ * @return true, якщо відповідь отримано.
+ */
+bool match_request(int fd, uint32_t dictionary, const string &text, MatchReply &reply) {
+    RequestHeader req = {REQUEST_MAGIC, dictionary, text.size()};
+    if (!send_all(fd, reinterpret_cast<const char *>(&req), sizeof(req)) ||
+        !send_all(fd, text.data(), text.size())) {
+        return false;
+    }
+
+    ResponseHeader h;
+    if (!recv_all(fd, reinterpret_cast<char *>(&h), sizeof(h)) || h.magic != RESPONSE_MAGIC) return false;
+    reply.status = h.status;
+    reply.total = h.total;
+    reply.counts.resize(h.pairs);
+    return h.pairs == 0 ||
+           recv_all(fd, reinterpret_cast<char *>(reply.counts.data()), h.pairs * sizeof(MatchCount));
+}
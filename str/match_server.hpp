@@ -0,0 +1,138 @@
+#pragma once
+#include "search_algorithms.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ---------------------- Протокол ----------------------
+// Обмін через Unix-сокет у порядку байтів хоста (сокет лише локальний).
+// Запит:   RequestHeader, потім length байтів тексту.
+// Відповідь: ResponseHeader, потім pairs пар MatchCount (лише ненульові лічильники).
+// З'єднання може передавати будь-яку кількість запитів поспіль.
+
+const uint32_t REQUEST_MAGIC = 0x51484f41;  ///< "AOHQ" у little-endian.
+const uint32_t RESPONSE_MAGIC = 0x52484f41; ///< "AOHR" у little-endian.
+const uint64_t MAX_REQUEST_BYTES = 64u << 20; ///< Найбільший текст одного запиту.
+
+/**
+ * @brief Заголовок запиту.
+ */
+struct RequestHeader {
+    uint32_t magic;      ///< REQUEST_MAGIC.
+    uint32_t dictionary; ///< Індекс словника на сервері.
+    uint64_t length;     ///< Довжина тексту в байтах.
+};
+
+/**
+ * @brief Стан обробки запиту.
+ */
+enum MatchStatus : uint32_t {
+    MATCH_OK = 0,                 ///< Запит виконано.
+    MATCH_UNKNOWN_DICTIONARY = 1, ///< Немає словника з таким індексом.
+    MATCH_TOO_LARGE = 2,          ///< Текст перевищує MAX_REQUEST_BYTES; з'єднання закривається.
+    MATCH_BAD_REQUEST = 3         ///< Неправильний magic; з'єднання закривається.
+};
+
+/**
+ * @brief Заголовок відповіді.
+ */
+struct ResponseHeader {
+    uint32_t magic;  ///< RESPONSE_MAGIC.
+    uint32_t status; ///< MatchStatus.
+    uint64_t total;  ///< Загальна кількість входжень.
+    uint32_t pairs;  ///< Кількість пар MatchCount після заголовка.
+    uint32_t reserved; ///< Нуль.
+};
+
+/**
+ * @brief Ненульовий лічильник шаблону у відповіді.
+ */
+struct MatchCount {
+    uint32_t pattern; ///< Індекс шаблону.
+    uint32_t count;   ///< Кількість входжень (насичується на UINT32_MAX).
+};
+
+/**
+ * @brief Результат запиту на стороні клієнта.
+ */
+struct MatchReply {
+    uint32_t status;                    ///< MatchStatus.
+    uint64_t total;                     ///< Загальна кількість входжень.
+    std::vector<MatchCount> counts;     ///< Ненульові лічильники в порядку першого збігу.
+};
+
+// ---------------------- Сервер ----------------------
+
+/**
+ * @brief Сервер пошуку з наперед побудованими автоматами.
+ *
+ * Один потік подій (poll) приймає з'єднання й дочитує запити без
+ * блокування; текст запиту читається одразу в буфер з'єднання, у якому й
+ * виконується пошук, тож байти не копіюються після recv; буфер росте в
+ * міру надходження тексту. Усі запити, що стали готовими за одну ітерацію,
+ * обробляються пакетом на threads потоках, після чого відповіді
+ * надсилаються без блокування: решта відповіді, яку сокет не прийняв,
+ * дописується, коли він стане доступним для запису, тож повільний клієнт
+ * не затримує інших.
+ */
+struct MatchServer {
+    std::vector<AhoCorasick> dictionaries; ///< Словники; індекс — номер у запиті.
+    unsigned threads;                      ///< Потоки для обробки пакета.
+    int listen_fd;                         ///< Слухаючий сокет (-1, якщо немає).
+    int wake_pipe[2];                      ///< Канал для зупинки циклу подій.
+    std::string path;                      ///< Шлях сокета.
+    size_t batches;                        ///< Кількість оброблених пакетів.
+    size_t requests;                       ///< Кількість оброблених запитів.
+
+    /**
+     * @brief Створює сервер без словників.
+     * @param threads_ Потоки для обробки пакета.
+     */
+    explicit MatchServer(unsigned threads_ = 1);
+
+    /**
+     * @brief Закриває сокет і видаляє його файл.
+     */
+    ~MatchServer();
+
+    MatchServer(const MatchServer &) = delete;
+    MatchServer &operator=(const MatchServer &) = delete;
+
+    /**
+     * @brief Створює слухаючий сокет (наявний файл сокета замінюється).
+     * @param socket_path Шлях сокета.
+     * @return true, якщо сокет готовий.
+     */
+    bool listen(const std::string &socket_path);
+
+    /**
+     * @brief Виконує цикл подій до виклику stop().
+     */
+    void run();
+
+    /**
+     * @brief Просить цикл подій завершитися; безпечно викликати з іншого потоку.
+     */
+    void stop();
+};
+
+// ---------------------- Клієнт ----------------------
+
+/**
+ * @brief Під'єднується до сервера.
+ * @param socket_path Шлях сокета.
+ * @return Дескриптор або -1.
+ */
+int match_connect(const std::string &socket_path);
+
+/**
+ * @brief Надсилає запит і чекає на відповідь.
+ * @param fd Під'єднаний сокет.
+ * @param dictionary Індекс словника.
+ * @param text Текст для пошуку.
+ * @param reply Відповідь сервера.
+ * @return true, якщо відповідь отримано (її статус див. у reply).
+ */
+bool match_request(int fd, uint32_t dictionary, const std::string &text, MatchReply &reply);
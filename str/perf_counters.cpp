@@ -0,0 +1,205 @@
+#include "perf_counters.hpp"
+#include <iomanip>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/**
+ * @brief Створює порожній вимір.
+ */
+PerfSample::PerfSample() {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        valid[e] = false;
+        value[e] = 0;
+    }
+}
+
+/**
+ * @brief Перевіряє наявність хоча б одного значення.
+ * @return true, якщо є виміряна подія.
+ */
+bool PerfSample::any() const {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (valid[e]) return true;
+    }
+    return false;
+}
+
+#ifdef __linux__
+/**
+ * @brief Заповнює опис події perf_event_attr.
+ *
+ * @param event Подія.
+ * @param attr Структура, що заповнюється.
+ */
+static void describe_event(int event, perf_event_attr &attr) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // потоки, запущені під час виміру, успадковують лічильник; їхні значення
+    // додаються до батьківського, коли потік завершується
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    const uint64_t read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    switch (event) {
+    case PERF_CYCLES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_L1D_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+        break;
+    case PERF_LLC_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        break;
+    case PERF_BRANCH_MISSES:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    case PERF_DTLB_MISSES:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+        break;
+    }
+}
+#endif
+
+/**
+ * @brief Відкриває лічильники для поточного потоку та його нових потоків.
+ *
+ * Помилка відкриття окремої події не є фатальною: її дескриптор
+ * залишається -1.
+ */
+PerfCounters::PerfCounters() {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        fd[e] = -1;
+#ifdef __linux__
+        perf_event_attr attr;
+        describe_event(e, attr);
+        fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+}
+
+/**
+ * @brief Закриває відкриті лічильники.
+ */
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (fd[e] != -1) close(fd[e]);
+    }
+#endif
+}
+
+/**
+ * @brief Перевіряє наявність хоча б одного лічильника.
+ * @return true, якщо вимірювання можливе.
+ */
+bool PerfCounters::available() const {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (fd[e] != -1) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Скидає та вмикає лічильники.
+ */
+void PerfCounters::start() {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (fd[e] == -1) continue;
+        ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/**
+ * @brief Вимикає лічильники та зчитує значення.
+ *
+ * Значення масштабується як value * time_enabled / time_running, якщо
+ * подія рахувалась не весь час через мультиплексування.
+ *
+ * @return Значення подій.
+ */
+PerfSample PerfCounters::stop() {
+    PerfSample sample;
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (fd[e] != -1) ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (fd[e] == -1) continue;
+        uint64_t data[3]; // value, time_enabled, time_running
+        if (read(fd[e], data, sizeof(data)) != (ssize_t)sizeof(data)) continue;
+        if (data[2] == 0) continue; // подія жодного разу не потрапила на PMU
+        sample.valid[e] = true;
+        sample.value[e] = data[2] < data[1]
+            ? (uint64_t)((long double)data[0] * data[1] / data[2])
+            : data[0];
+    }
+#endif
+    return sample;
+}
+
+/**
+ * @brief Повертає коротку назву події.
+ * @param event Подія.
+ * @return Назва події.
+ */
+const char *PerfCounters::event_name(int event) {
+    switch (event) {
+    case PERF_CYCLES: return "cycles";
+    case PERF_INSTRUCTIONS: return "instructions";
+    case PERF_L1D_MISSES: return "l1d_misses";
+    case PERF_LLC_MISSES: return "llc_misses";
+    case PERF_BRANCH_MISSES: return "branch_misses";
+    case PERF_DTLB_MISSES: return "dtlb_misses";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Друкує значення лічильників.
+ *
+ * @param os Потік виводу.
+ * @param sample Вимір.
+ * @param indent Відступ рядків.
+ */
+void print_perf(ostream &os, const PerfSample &sample, const char *indent) {
+    if (!sample.any()) {
+        os << indent << "Perf counters: n/a (perf_event_open unavailable)\n";
+        return;
+    }
+    ios::fmtflags flags = os.flags();
+    streamsize precision = os.precision();
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        os << indent << left << setw(15) << PerfCounters::event_name(e) << right;
+        if (sample.valid[e]) os << sample.value[e] << "\n";
+        else os << "n/a\n";
+    }
+    if (sample.valid[PERF_CYCLES] && sample.valid[PERF_INSTRUCTIONS] && sample.value[PERF_CYCLES] > 0) {
+        os << indent << left << setw(15) << "ipc" << right << fixed << setprecision(2)
+           << (double)sample.value[PERF_INSTRUCTIONS] / sample.value[PERF_CYCLES] << "\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Апаратні події, які вимірюються навколо побудови та пошуку.
+ */
+enum PerfEvent {
+    PERF_CYCLES,        ///< Такти процесора.
+    PERF_INSTRUCTIONS,  ///< Виконані інструкції.
+    PERF_L1D_MISSES,    ///< Промахи читання кешу даних L1.
+    PERF_LLC_MISSES,    ///< Промахи кешу останнього рівня.
+    PERF_BRANCH_MISSES, ///< Хибно передбачені переходи.
+    PERF_DTLB_MISSES,   ///< Промахи читання TLB даних.
+    PERF_EVENT_COUNT    ///< Кількість подій.
+};
+
+/**
+ * @brief Значення лічильників за один вимір.
+ *
+ * Подія, яку не вдалося відкрити або прочитати, позначається valid = false.
+ * Якщо ядро мультиплексувало лічильники, значення масштабуються на частку
+ * часу, протягом якого подія фактично рахувалась.
+ */
+struct PerfSample {
+    bool valid[PERF_EVENT_COUNT];     ///< Чи є значення для події.
+    uint64_t value[PERF_EVENT_COUNT]; ///< Значення події.
+
+    /**
+     * @brief Створює вимір без жодного значення.
+     */
+    PerfSample();
+
+    /**
+     * @brief Перевіряє, чи є хоча б одне значення.
+     * @return true, якщо хоча б одна подія виміряна.
+     */
+    bool any() const;
+};
+
+/**
+ * @brief Набір апаратних лічильників продуктивності (Linux perf_event_open).
+ *
+ * Кожна подія відкривається окремо для поточного потоку, лише в режимі
+ * користувача, з успадкуванням: потоки, створені ним після відкриття,
+ * рахуються разом із ним. Значення завершеного потоку додається до
+ * загального, тож вимір включає роботу робочих потоків, якщо вони
+ * приєднані (join) до stop(). Якщо ядро або середовище не дозволяє
+ * відкрити лічильник (немає PMU, perf_event_paranoid, контейнер, не Linux),
+ * подія просто пропускається, і вимір повертає для неї valid = false.
+ */
+struct PerfCounters {
+    int fd[PERF_EVENT_COUNT]; ///< Дескриптори подій (-1, якщо недоступна).
+
+    /**
+     * @brief Відкриває всі доступні лічильники (у вимкненому стані).
+     */
+    PerfCounters();
+
+    /**
+     * @brief Закриває відкриті лічильники.
+     */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    /**
+     * @brief Перевіряє, чи відкрито хоча б один лічильник.
+     * @return true, якщо вимірювання можливе.
+     */
+    bool available() const;
+
+    /**
+     * @brief Скидає та вмикає лічильники.
+     */
+    void start();
+
+    /**
+     * @brief Вимикає лічильники та зчитує їхні значення.
+     * @return Значення подій з моменту start().
+     */
+    PerfSample stop();
+
+    /**
+     * @brief Повертає коротку назву події.
+     * @param event Подія.
+     * @return Назва, придатна для виводу та JSON.
+     */
+    static const char *event_name(int event);
+};
+
+/**
+ * @brief Виконує функцію та вимірює апаратні події під час її виконання.
+ *
+ * @param counters Відкриті лічильники.
+ * @param f Функція, що вимірюється.
+ * @return Значення подій.
+ */
+template <typename Func>
+PerfSample measure_perf(PerfCounters &counters, Func f) {
+    counters.start();
+    f();
+    return counters.stop();
+}
+
+/**
+ * @brief Друкує значення лічильників (або "n/a" для недоступних подій).
+ *
+ * Окрім сирих значень друкує IPC, якщо виміряні такти та інструкції.
+ *
+ * @param os Потік виводу.
+ * @param sample Вимір.
+ * @param indent Відступ на початку кожного рядка.
+ */
+void print_perf(std::ostream &os, const PerfSample &sample, const char *indent);
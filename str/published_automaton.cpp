@@ -0,0 +1,134 @@
+#include "published_automaton.hpp"
+#include <thread>
+using namespace std;
+
+/**
+ * @brief Створює вільний слот читача.
+ */
+PublishedAutomaton::ReaderSlot::ReaderSlot() : epoch(0) {}
+
+/**
+ * @brief Створює доступ читача до зайнятого слота.
+ * @param owner_ Власник слота.
+ * @param slot_ Зайнятий слот.
+ * @param automaton_ Автомат, видимий читачу.
+ */
+PublishedAutomaton::Reader::Reader(PublishedAutomaton *owner_, size_t slot_, const AhoCorasick *automaton_)
+    : owner(owner_), slot(slot_), automaton(automaton_) {}
+
+/**
+ * @brief Переносить слот з іншого читача.
+ * @param other Читач, що втрачає слот.
+ */
+PublishedAutomaton::Reader::Reader(Reader &&other)
+    : owner(other.owner), slot(other.slot), automaton(other.automaton) {
+    other.owner = nullptr;
+}
+
+/**
+ * @brief Звільняє слот читача.
+ */
+PublishedAutomaton::Reader::~Reader() {
+    if (owner) owner->slots[slot].epoch.store(0, memory_order_release);
+}
+
+/**
+ * @brief Публікує початковий автомат.
+ * @param initial Початковий автомат.
+ * @param max_readers Кількість слотів читачів.
+ */
+PublishedAutomaton::PublishedAutomaton(unique_ptr<AhoCorasick> initial, size_t max_readers)
+    : current(initial.release()), global_epoch(1), slots(max_readers ? max_readers : 1) {}
+
+/**
+ * @brief Звільняє поточний і відкладені автомати.
+ */
+PublishedAutomaton::~PublishedAutomaton() {
+    for (const Retired &r : retired) delete r.automaton;
+    delete current.load();
+}
+
+/**
+ * @brief Починає читання.
+ *
+ * Порядок важливий: епоха записується в слот раніше, ніж читається
+ * вказівник. Якщо читач побачив старий автомат, то його слот було зайнято
+ * до заміни, і письменник побачить у ньому епоху, не більшу за епоху заміни.
+ *
+ * @return Доступ читача.
+ */
+PublishedAutomaton::Reader PublishedAutomaton::read() {
+    size_t start = hash<thread::id>()(this_thread::get_id());
+    for (;;) {
+        for (size_t k = 0; k < slots.size(); ++k) {
+            size_t i = (start + k) % slots.size();
+            uint64_t expected = 0;
+            uint64_t epoch = global_epoch.load();
+            if (slots[i].epoch.compare_exchange_strong(expected, epoch)) {
+                return Reader(this, i, current.load());
+            }
+        }
+        this_thread::yield(); // усі слоти зайняті
+    }
+}
+
+/**
+ * @brief Звільняє відкладені автомати, яких не бачить жоден читач.
+ *
+ * Викликається під writer_lock.
+ *
+ * @param pub Опублікований автомат.
+ * @return Кількість автоматів, що лишилися відкладеними.
+ */
+static size_t reclaim_retired(PublishedAutomaton &pub) {
+    uint64_t oldest = UINT64_MAX; // найменша епоха серед активних читачів
+    for (const PublishedAutomaton::ReaderSlot &s : pub.slots) {
+        uint64_t e = s.epoch.load();
+        if (e != 0 && e < oldest) oldest = e;
+    }
+
+    size_t kept = 0;
+    for (const PublishedAutomaton::Retired &r : pub.retired) {
+        if (r.epoch < oldest) delete r.automaton;
+        else pub.retired[kept++] = r;
+    }
+    pub.retired.resize(kept);
+    return kept;
+}
+
+/**
+ * @brief Атомарно замінює автомат.
+ * @param next Новий автомат.
+ * @return Номер нової версії.
+ */
+uint64_t PublishedAutomaton::publish(unique_ptr<AhoCorasick> next) {
+    lock_guard<mutex> guard(writer_lock);
+    const AhoCorasick *old = current.exchange(next.release());
+    uint64_t epoch = global_epoch.fetch_add(1);
+    retired.push_back({old, epoch});
+    reclaim_retired(*this);
+    return epoch;
+}
+
+/**
+ * @brief Будує та публікує новий автомат у фоновому потоці.
+ * @param patterns Новий словник.
+ * @param options Семантика збігу.
+ * @return Майбутній номер нової версії.
+ */
+future<uint64_t> PublishedAutomaton::reload(vector<string> patterns, const MatchOptions &options) {
+    return async(launch::async, [this, options](vector<string> dictionary) {
+        unique_ptr<AhoCorasick> next(new AhoCorasick());
+        next->build_automaton(dictionary, options);
+        return publish(move(next));
+    }, move(patterns));
+}
+
+/**
+ * @brief Звільняє відкладені автомати, яких уже не може бачити жоден читач.
+ * @return Кількість автоматів, що лишилися відкладеними.
+ */
+size_t PublishedAutomaton::reclaim() {
+    lock_guard<mutex> guard(writer_lock);
+    return reclaim_retired(*this);
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "search_algorithms.hpp"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Опублікований автомат із гарячою заміною без блокування читачів.
+ *
+ * Читач бере Reader: займає вільний слот, записує в нього поточну епоху й
+ * лише потім читає вказівник на автомат. Письменник атомарно підміняє
+ * вказівник, збільшує епоху та відкладає старий автомат із номером епохи
+ * заміни. Старий автомат звільняється, коли жоден зайнятий слот не має
+ * епохи, не більшої за цей номер: усі читачі, що могли його побачити,
+ * уже завершилися.
+ *
+ * Читачі не беруть м'ютексів і не чекають на письменника; кількість
+ * одночасних читачів обмежена кількістю слотів (зайвий читач чекає,
+ * доки звільниться слот). Письменники серіалізуються між собою.
+ */
+struct PublishedAutomaton {
+    /**
+     * @brief Слот читача на окремій кеш-лінії, щоб читачі не заважали один одному.
+     */
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch; ///< Епоха читача (0 — слот вільний).
+        ReaderSlot();
+    };
+
+    /**
+     * @brief Доступ читача до автомата; поки він існує, автомат не звільниться.
+     */
+    struct Reader {
+        PublishedAutomaton *owner;     ///< Власник слота.
+        size_t slot;                   ///< Зайнятий слот.
+        const AhoCorasick *automaton;  ///< Автомат, видимий цьому читачу.
+
+        Reader(PublishedAutomaton *owner_, size_t slot_, const AhoCorasick *automaton_);
+        Reader(Reader &&other);
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+        Reader &operator=(Reader &&) = delete;
+
+        /**
+         * @brief Звільняє слот.
+         */
+        ~Reader();
+
+        const AhoCorasick &operator*() const { return *automaton; }
+        const AhoCorasick *operator->() const { return automaton; }
+    };
+
+    /**
+     * @brief Автомат, замінений, але ще, можливо, видимий читачам.
+     */
+    struct Retired {
+        const AhoCorasick *automaton; ///< Старий автомат.
+        uint64_t epoch;               ///< Епоха, у якій його замінено.
+    };
+
+    std::atomic<const AhoCorasick *> current; ///< Поточний автомат.
+    std::atomic<uint64_t> global_epoch;        ///< Епоха; збільшується з кожною заміною.
+    std::vector<ReaderSlot> slots;             ///< Слоти читачів.
+    std::vector<Retired> retired;              ///< Замінені автомати (під writer_lock).
+    std::mutex writer_lock;                    ///< Серіалізує письменників.
+
+    /**
+     * @brief Публікує початковий автомат.
+     * @param initial Початковий автомат.
+     * @param max_readers Кількість слотів для одночасних читачів.
+     */
+    explicit PublishedAutomaton(std::unique_ptr<AhoCorasick> initial, size_t max_readers = 128);
+
+    /**
+     * @brief Звільняє поточний і всі відкладені автомати (читачів уже не має бути).
+     */
+    ~PublishedAutomaton();
+
+    PublishedAutomaton(const PublishedAutomaton &) = delete;
+    PublishedAutomaton &operator=(const PublishedAutomaton &) = delete;
+
+    /**
+     * @brief Починає читання поточного автомата.
+     * @return Доступ читача.
+     */
+    Reader read();
+
+    /**
+     * @brief Атомарно замінює автомат і звільняє ті старі, яких уже ніхто не читає.
+     * @param next Новий автомат.
+     * @return Номер нової версії (кількість замін).
+     */
+    uint64_t publish(std::unique_ptr<AhoCorasick> next);
+
+    /**
+     * @brief Будує новий автомат у фоновому потоці й публікує його.
+     *
+     * Читачі продовжують працювати зі старим автоматом, доки будується новий.
+     *
+     * @param patterns Новий словник.
+     * @param options Семантика збігу.
+     * @return Майбутній номер нової версії.
+     */
+    std::future<uint64_t> reload(std::vector<std::string> patterns,
+                                 const MatchOptions &options = {CaseMode::AsciiFold, Scope::WithinWord});
+
+    /**
+     * @brief Звільняє відкладені автомати, яких уже не може бачити жоден читач.
+     * @return Кількість автоматів, що лишилися відкладеними.
+     */
+    size_t reclaim();
+};
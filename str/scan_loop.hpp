@@ -0,0 +1,104 @@
+#pragma once
+#include "search_algorithms.hpp"
+#include <cstddef>
+
+/**
+ * @brief Стан сканування між викликами scan_loop.
+ */
+struct ScanState {
+    int state;       ///< Поточна вершина автомата.
+    size_t word_len; ///< Довжина незавершеного слова (лише для Scope::WholeWord).
+};
+
+/**
+ * @brief Спільний цикл сканування для всіх подань автомата.
+ *
+ * Automaton надає доступ до переходів і виходів і має поля та методи:
+ * - scope — семантика меж збігу;
+ * - step(v, c) — вершина після байта c;
+ * - out_begin(v), out_end(v) — індекси шаблонів, що закінчуються у вершині v
+ *   (власні шаблони вершини першими, від найдовшого);
+ * - pattern_len(idx) — довжина нормалізованого шаблону.
+ * Тому AhoCorasick і його образ без вказівників (FlatAutomatonView)
+ * шукають одним і тим самим кодом.
+ *
+ * Для Scope::WholeWord прохід іде лише по байтах слова; на першому байті
+ * поза словом перевіряються виходи поточної вершини: збігом є лише власний
+ * шаблон вершини завдовжки з усе слово. Слово, що закінчується на to,
+ * перевіряється, лише якщо word_ends_at_to; інакше воно лишається в state
+ * незавершеним і продовжується наступним викликом.
+ *
+ * Лічильник збігів ведеться тут, у регістрі, а не в обробнику: запис
+ * через вказівник на лічильники інакше змушує компілятор перечитувати
+ * захоплену за посиланням суму на кожному збігу.
+ *
+ * @param a Подання автомата.
+ * @param bytes Байти тексту.
+ * @param from Позиція початку сканування.
+ * @param count_from Перша позиція кінця збігу, про яку повідомляється.
+ * @param to Позиція кінця сканування (не включно).
+ * @param word_ends_at_to Чи закінчується на to слово (Scope::WholeWord).
+ * @param st Стан на початку; після виклику — стан на позиції to.
+ * @param on_match Викликається як on_match(кінець, індекс) для кожного збігу,
+ *        де кінець — позиція останнього байта; false зупиняє сканування.
+ * @return Кількість збігів, переданих обробнику.
+ */
+template <typename Automaton, typename OnMatch>
+inline size_t scan_loop(const Automaton &a, const char *bytes, size_t from, size_t count_from, size_t to,
+                        bool word_ends_at_to, ScanState &st, OnMatch on_match) {
+    size_t total_matches = 0;
+    int v = st.state;
+
+    if (a.scope != Scope::WholeWord) {
+        for (size_t i = from; i < to; ++i) {
+            v = a.step(v, (unsigned char)bytes[i]);
+            if (i < count_from) continue;
+
+            // усі патерни, що закінчуються в цій вершині
+            for (const int *p = a.out_begin(v), *e = a.out_end(v); p != e; ++p) {
+                ++total_matches;
+                if (!on_match(i, *p)) {
+                    st.state = v;
+                    return total_matches;
+                }
+            }
+        }
+        st.state = v;
+        return total_matches;
+    }
+
+    size_t word_len = st.word_len;
+    auto word_end = [&](size_t last) {
+        if (last < count_from) return true;
+        for (const int *p = a.out_begin(v), *e = a.out_end(v); p != e; ++p) {
+            if ((size_t)a.pattern_len(*p) != word_len) break;
+            ++total_matches;
+            if (!on_match(last, *p)) return false;
+        }
+        return true;
+    };
+
+    for (size_t i = from; i < to; ++i) {
+        unsigned char c = (unsigned char)bytes[i];
+        if (is_word_byte(c)) {
+            v = a.step(v, c);
+            ++word_len;
+        } else {
+            if (word_len != 0 && !word_end(i - 1)) {
+                st.state = v;
+                st.word_len = word_len;
+                return total_matches;
+            }
+            v = 0;
+            word_len = 0;
+        }
+    }
+    if (word_len != 0 && word_ends_at_to) {
+        word_end(to - 1);
+        v = 0;
+        word_len = 0;
+    }
+    st.state = v;
+    st.word_len = word_len;
+    return total_matches;
+}
@@ -1,8 +1,180 @@
 #include "search_algorithms.hpp"
+#include "scan_loop.hpp"
 #include <queue>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
 using namespace std;
 
+/**
+ * @brief Проста згортка регістру для латиниці та кирилиці.
+ *
+ * Повертає малу форму лише тоді, коли вона кодується в UTF-8 тією ж
+ * кількістю байтів, що й велика (тому, наприклад, İ і ſ не згортаються).
+ *
+ * @param cp Кодова точка.
+ * @return Мала форма або cp без змін.
+ */
+static uint32_t simple_fold(uint32_t cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 0x20;
+    if (cp < 0xC0) return cp;
+    // Latin-1 Supplement: À..Þ, крім ×
+    if (cp <= 0xDE) return cp == 0xD7 ? cp : cp + 0x20;
+    if (cp < 0x100) return cp;
+    // Latin Extended-A: пари «велика, мала»
+    if (cp <= 0x12F || (cp >= 0x132 && cp <= 0x137)) return cp | 1;
+    if (cp >= 0x139 && cp <= 0x148) return (cp & 1) ? cp + 1 : cp;
+    if (cp >= 0x14A && cp <= 0x177) return cp | 1;
+    if (cp == 0x178) return 0xFF;
+    if (cp >= 0x179 && cp <= 0x17E) return (cp & 1) ? cp + 1 : cp;
+    if (cp < 0x400) return cp;
+    // кирилиця
+    if (cp <= 0x40F) return cp + 0x50;
+    if (cp <= 0x42F) return cp + 0x20;
+    if (cp < 0x460) return cp;
+    if (cp <= 0x481 || (cp >= 0x48A && cp <= 0x4BF)) return cp | 1;
+    if (cp == 0x4C0) return 0x4CF;
+    if (cp >= 0x4C1 && cp <= 0x4CE) return (cp & 1) ? cp + 1 : cp;
+    if (cp >= 0x4D0 && cp <= 0x52F) return cp | 1;
+    return cp;
+}
+
+/**
+ * @brief Згортає регістр двобайтових символів UTF-8 і ASCII.
+ *
+ * @param in Вхідний текст.
+ * @param out Текст після згортки (тієї ж довжини).
+ */
+static void fold_utf8(const string &in, string &out) {
+    out = in;
+    size_t n = out.size();
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)out[i];
+        if (c < 0x80) {
+            if ((unsigned char)(c - 'A') < 26) out[i] = (char)(c | 0x20);
+            continue;
+        }
+        if (c < 0xC2 || c > 0xDF || i + 1 >= n) continue;
+        unsigned char c2 = (unsigned char)out[i + 1];
+        if ((c2 & 0xC0) != 0x80) continue;
+
+        uint32_t cp = simple_fold(((uint32_t)(c & 0x1F) << 6) | (c2 & 0x3F));
+        out[i] = (char)(0xC0 | (cp >> 6));
+        out[i + 1] = (char)(0x80 | (cp & 0x3F));
+        ++i;
+    }
+}
+
+/**
+ * @brief Переводить A..Z у a..z одним проходом без розгалужень.
+ *
+ * Тіло циклу — лише порівняння й OR, тож компілятор векторизує його.
+ *
+ * @param in Вхідний текст.
+ * @param out Текст у нижньому регістрі.
+ */
+static void fold_ascii(const string &in, string &out) {
+    out.resize(in.size());
+    const unsigned char *src = reinterpret_cast<const unsigned char *>(in.data());
+    unsigned char *dst = reinterpret_cast<unsigned char *>(&out[0]);
+    for (size_t i = 0; i < in.size(); ++i) {
+        unsigned char c = src[i];
+        dst[i] = c | (unsigned char)(((unsigned char)(c - 'A') < 26) << 5);
+    }
+}
+
+/**
+ * @brief Згортка регістру згідно з режимом.
+ *
+ * @param text Вхідний текст.
+ * @param mode Режим врахування регістру.
+ * @return Текст після згортки.
+ */
+string fold_case(const string &text, CaseMode mode) {
+    string out;
+    if (mode == CaseMode::Sensitive) out = text;
+    else if (mode == CaseMode::AsciiFold) fold_ascii(text, out);
+    else fold_utf8(text, out);
+    return out;
+}
+
+/**
+ * @brief Нормалізує шаблон згідно із семантикою збігу.
+ *
+ * @param pattern Вихідний шаблон.
+ * @param options Семантика збігу.
+ * @return Нормалізований шаблон.
+ */
+string normalize_pattern(const string &pattern, const MatchOptions &options) {
+    string out;
+    out.reserve(pattern.size());
+    for (unsigned char c : pattern) {
+        if (options.scope != Scope::Substring && !is_word_byte(c)) continue;
+        out += (char)c;
+    }
+    return fold_case(out, options.case_mode);
+}
+
+/**
+ * @brief Спільна частина наївного пошуку для всіх видів результату.
+ *
+ * За згортки регістру текст один раз переводиться в нижній регістр,
+ * шаблони нормалізуються, після чого кожен шукається через std::string::find.
+ * Для Scope::WithinWord окремої перевірки не потрібно: нормалізований шаблон
+ * складається лише з байтів слова, тож будь-яке його входження лежить у
+ * межах слова. Для Scope::WholeWord додатково перевіряються байти по обидва
+ * боки входження.
+ *
+ * @param text Текст для пошуку.
+ * @param patterns Список шаблонів.
+ * @param options Семантика збігу.
+ * @param on_count Викликається як on_count(індекс, кількість) для шаблонів із входженнями.
+ * @return Загальна кількість входжень.
+ */
+template <typename OnCount>
+static size_t naive_scan(const string &text, const vector<string> &patterns,
+                         const MatchOptions &options, OnCount on_count) {
+    bool exact = options.case_mode == CaseMode::Sensitive && options.scope == Scope::Substring;
+    string folded;
+    const string *hay = &text;
+    if (options.case_mode != CaseMode::Sensitive) {
+        folded = fold_case(text, options.case_mode);
+        hay = &folded;
+    }
+
+    bool whole = options.scope == Scope::WholeWord;
+    size_t total_matches = 0;
+    string norm;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        const string *p = &patterns[i];
+        if (!exact) {
+            norm = normalize_pattern(patterns[i], options);
+            p = &norm;
+        }
+        if (p->empty()) continue;
+
+        size_t found = 0;
+        size_t pos = hay->find(*p, 0);
+        while (pos != string::npos) {
+            size_t end = pos + p->size();
+            if (!whole || ((pos == 0 || !is_word_byte(text[pos - 1])) &&
+                           (end == text.size() || !is_word_byte(text[end])))) {
+                ++found;
+            }
+            pos = hay->find(*p, pos + 1);
+        }
+        if (found) {
+            on_count(i, found);
+            total_matches += found;
+        }
+    }
+
+    return total_matches;
+}
+
 /**
  * @brief Наївний пошук шаблонів у тексті.
  *
@@ -12,106 +184,313 @@ using namespace std;
  * @param text Текст для пошуку шаблонів.
  * @param patterns Список шаблонів для пошуку.
  * @param per_pattern Вектор, який зберігає кількість входжень кожного шаблону.
+ * @param options Семантика збігу.
  * @return Загальна кількість входжень усіх шаблонів.
  */
 size_t naive_search(const string &text,
                     const vector<string> &patterns,
-                    vector<size_t> &per_pattern) {
+                    vector<size_t> &per_pattern,
+                    const MatchOptions &options) {
     per_pattern.assign(patterns.size(), 0);
-    size_t total_matches = 0;
+    return naive_accumulate(text, patterns, per_pattern.data(), options);
+}
 
-    for (size_t i = 0; i < patterns.size(); ++i) {
-        const string &p = patterns[i];
-        if (p.empty()) continue;
+/**
+ * @brief Створює порожній розріджений результат.
+ */
+SparseCounts::SparseCounts() : total(0) {}
 
-        size_t pos = text.find(p, 0);
-        while (pos != string::npos) {
-            ++per_pattern[i];
-            ++total_matches;
-            pos = text.find(p, pos + 1);
-        }
-    }
+/**
+ * @brief Скидає результат перед новим пошуком.
+ *
+ * Обнуляються лише лічильники з touched, тож вартість не залежить
+ * від розміру словника.
+ *
+ * @param n_patterns Кількість шаблонів.
+ */
+void SparseCounts::reset(size_t n_patterns) {
+    for (int idx : touched) counts[idx] = 0;
+    touched.clear();
+    total = 0;
+    if (counts.size() < n_patterns) counts.resize(n_patterns, 0);
+}
 
-    return total_matches;
+/**
+ * @brief Повертає кількість входжень шаблону.
+ * @param idx Індекс шаблону.
+ * @return Кількість входжень.
+ */
+size_t SparseCounts::count(int idx) const {
+    if (idx < 0 || (size_t)idx >= counts.size()) return 0;
+    return counts[idx];
+}
+
+/**
+ * @brief Наївний пошук із розрідженим результатом.
+ *
+ * @param text Текст для пошуку шаблонів.
+ * @param patterns Список шаблонів для пошуку.
+ * @param result Розріджений результат.
+ * @param options Семантика збігу.
+ * @return Загальна кількість входжень усіх шаблонів.
+ */
+size_t naive_search(const string &text,
+                    const vector<string> &patterns,
+                    SparseCounts &result,
+                    const MatchOptions &options) {
+    result.reset(patterns.size());
+    result.total = naive_scan(text, patterns, options, [&](size_t i, size_t found) {
+        result.touched.push_back((int)i);
+        result.counts[i] = found;
+    });
+    return result.total;
+}
+
+/**
+ * @brief Наївний пошук із накопиченням у наявні лічильники.
+ *
+ * @param text Текст для пошуку шаблонів.
+ * @param patterns Список шаблонів для пошуку.
+ * @param counts Лічильники, до яких додаються входження.
+ * @param options Семантика збігу.
+ * @return Кількість входжень, знайдених у цьому тексті.
+ */
+size_t naive_accumulate(const string &text,
+                        const vector<string> &patterns,
+                        size_t *counts,
+                        const MatchOptions &options) {
+    return naive_scan(text, patterns, options, [&](size_t i, size_t found) {
+        counts[i] += found;
+    });
 }
 
 /**
  * @brief Конструктор вершини AhoNode.
- * Встановлює значення за замовчуванням для переходів та суфіксного посилання.
+ * Встановлює значення за замовчуванням для суфіксного посилання.
  */
 AhoNode::AhoNode() {
-    fill(begin(next), end(next), -1);
     link = -1;
 }
 
 /**
  * @brief Створює автомат Ахо–Корасіка.
- * Початково автомат має лише кореневу вершину.
+ * Початково автомат має лише кореневу вершину, а всі байти — клас 0.
  */
-AhoCorasick::AhoCorasick() {
+AhoCorasick::AhoCorasick() : options{CaseMode::AsciiFold, Scope::WithinWord}, alpha(1), max_len(0) {
+    fill(begin(byte_class), end(byte_class), 0);
     trie.emplace_back();
+    next.assign(alpha, 0);
 }
 
 /**
- * @brief Перетворює символ у індекс від 0 до 25.
- *
- * Для літер a..z та A..Z, але не для інших символів.
+ * @brief Повертає клас байта.
  *
  * @param c Символ для перетворення.
- * @return Індекс символу або -1 для некоректних символів.
+ * @return Клас байта (0 для байтів, яких немає в шаблонах).
  */
-int AhoCorasick::char_id(char c) {
-    if (c >= 'a' && c <= 'z') return c - 'a';
-    if (c >= 'A' && c <= 'Z') return c - 'A';
-    return -1;
+int AhoCorasick::char_id(char c) const {
+    return byte_class[(unsigned char)c];
 }
 
 /**
  * @brief Додає шаблон до автомата Ахо–Корасіка.
  *
- * Кожен символ шаблону обробляється за допомогою переходів у бору.
- * Коли шаблон завершено, індекс шаблону додається до виходу поточної вершини.
+ * Кожен байт нормалізованого шаблону обробляється за допомогою переходів
+ * у бору. Коли шаблон завершено, індекс шаблону додається до виходу
+ * поточної вершини.
  *
  * @param s Рядок-шаблон для додавання.
  * @param idx Індекс шаблону.
  */
 void AhoCorasick::add_pattern(const string &s, int idx) {
+    string norm = normalize_pattern(s, options);
+    if ((int)pattern_len.size() <= idx) pattern_len.resize(idx + 1, 0);
+    pattern_len[idx] = (int)norm.size();
+
     int v = 0;
-    for (char c : s) {
-        int id = char_id(c);
-        if (id == -1) continue; // пропускаємо не-літери
-        if (trie[v].next[id] == -1) {
-            trie[v].next[id] = (int)trie.size();
+    for (unsigned char c : norm) {
+        int id = byte_class[c];
+        if (id == 0) return; // байт без класу: шаблон не може зустрітися
+        if (next[v * alpha + id] == -1) {
+            next[v * alpha + id] = (int)trie.size();
             trie.emplace_back();
+            next.resize(next.size() + alpha, -1);
+        }
+        v = next[v * alpha + id];
+    }
+    // шаблон, порожній після нормалізації, не може зустрітися; у корені він
+    // успадкувався б усіма вершинами і рахувався б на кожному байті
+    if (!norm.empty()) trie[v].out.push_back(idx);
+}
+
+/**
+ * @brief Кодує двобайтовий символ UTF-8.
+ * @param cp Кодова точка від U+0080 до U+07FF.
+ * @param bytes Два байти коду.
+ */
+static void encode_utf8_2(uint32_t cp, unsigned char bytes[2]) {
+    bytes[0] = (unsigned char)(0xC0 | (cp >> 6));
+    bytes[1] = (unsigned char)(0x80 | (cp & 0x3F));
+}
+
+/**
+ * @brief Повертає пари (мала форма, велика форма) для двобайтових символів.
+ *
+ * Обчислюється один раз із simple_fold, відсортовано за малою формою.
+ *
+ * @return Таблиця великих форм.
+ */
+static const vector<pair<uint32_t, uint32_t>> &upper_forms() {
+    static const vector<pair<uint32_t, uint32_t>> table = [] {
+        vector<pair<uint32_t, uint32_t>> t;
+        for (uint32_t cp = 0x80; cp < 0x800; ++cp) {
+            uint32_t lower = simple_fold(cp);
+            if (lower != cp) t.push_back({lower, cp});
         }
-        v = trie[v].next[id];
+        sort(t.begin(), t.end());
+        return t;
+    }();
+    return table;
+}
+
+/**
+ * @brief Обходить двобайтові символи нормалізованого шаблону, що мають велику форму.
+ *
+ * @param norm Нормалізований шаблон.
+ * @param f Викликається як f(мала форма, велика форма).
+ */
+template <typename F>
+static void for_each_upper_form(const string &norm, F f) {
+    const auto &table = upper_forms();
+    for (size_t i = 0; i + 1 < norm.size(); ++i) {
+        unsigned char c = (unsigned char)norm[i];
+        unsigned char c2 = (unsigned char)norm[i + 1];
+        if (c < 0xC2 || c > 0xDF || (c2 & 0xC0) != 0x80) continue;
+        uint32_t cp = ((uint32_t)(c & 0x1F) << 6) | (c2 & 0x3F);
+        auto range = equal_range(table.begin(), table.end(), make_pair(cp, 0u),
+                                 [](const pair<uint32_t, uint32_t> &x, const pair<uint32_t, uint32_t> &y) {
+                                     return x.first < y.first;
+                                 });
+        for (auto it = range.first; it != range.second; ++it) f(it->first, it->second);
+        ++i;
     }
-    trie[v].out.push_back(idx);
 }
 
 /**
  * @brief Створює автомат Ахо–Корасіка.
- * Будує бор за усіма шаблонами і встановлює суфіксні посилання.
+ * Призначає класи байтам, будує бор за усіма шаблонами і встановлює
+ * суфіксні посилання, доповнюючи таблицю переходів.
+ *
+ * Для CaseMode::UnicodeFold перед обходом у ширину кожна вершина u, з якої
+ * виходить шлях малої літери (два байти) у вершину w, отримує паралельний
+ * шлях байтів великої літери в ту саму w. Проміжна вершина цього шляху
+ * (після першого байта) є звичайною вершиною бору з батьком u, а останнє
+ * ребро — перехресне: воно не задає w суфіксне посилання. Обидва рядки
+ * згортаються в один, тож суфіксні посилання, обчислені по бору малих
+ * літер, лишаються правильними.
  *
  * @param patterns_ Список шаблонів для додавання в автомат.
+ * @param options_ Семантика збігу.
  */
-void AhoCorasick::build_automaton(const vector<string> &patterns_) {
+void AhoCorasick::build_automaton(const vector<string> &patterns_, const MatchOptions &options_) {
     patterns = patterns_;
+    options = options_;
+    bool unicode = options.case_mode == CaseMode::UnicodeFold;
+
+    // класи байтів: 0 — байти, яких немає в жодному шаблоні
+    fill(begin(byte_class), end(byte_class), 0);
+    alpha = 1;
+    auto assign_class = [&](unsigned char c) {
+        if (byte_class[c] == 0) byte_class[c] = (unsigned short)alpha++;
+    };
+    for (const string &p : patterns) {
+        string norm = normalize_pattern(p, options);
+        for (unsigned char c : norm) assign_class(c);
+        if (unicode) {
+            for_each_upper_form(norm, [&](uint32_t, uint32_t upper) {
+                unsigned char bytes[2];
+                encode_utf8_2(upper, bytes);
+                assign_class(bytes[0]);
+                assign_class(bytes[1]);
+            });
+        }
+    }
+    if (options.case_mode != CaseMode::Sensitive) {
+        for (int c = 'A'; c <= 'Z'; ++c) byte_class[c] = byte_class[c | 0x20];
+    }
+
+    trie.assign(1, AhoNode());
+    next.assign(alpha, -1);
+    pattern_len.assign(patterns.size(), 0);
     for (int i = 0; i < (int)patterns.size(); ++i) {
         if (!patterns[i].empty()) add_pattern(patterns[i], i);
     }
+    max_len = 0;
+    for (int len : pattern_len) max_len = max(max_len, len);
+
+    // ребро бору, що веде в кожну вершину: перехресні ребра з ним не збігаються
+    vector<int> parent(trie.size(), -1), parent_class(trie.size(), 0);
+    for (int v = 0; v < (int)trie.size(); ++v) {
+        for (int c = 0; c < alpha; ++c) {
+            int to = next[v * alpha + c];
+            if (to != -1) {
+                parent[to] = v;
+                parent_class[to] = c;
+            }
+        }
+    }
+    auto is_tree_edge = [&](int v, int c, int to) {
+        return parent[to] == v && parent_class[to] == c;
+    };
+
+    if (unicode) {
+        // байт, що представляє клас (для байтів від 0x80 він єдиний)
+        vector<unsigned char> class_byte(alpha, 0);
+        for (int b = 0x80; b < 256; ++b) class_byte[byte_class[b]] = (unsigned char)b;
+
+        int tree_size = (int)trie.size();
+        for (int u = 0; u < tree_size; ++u) {
+            for (int c = 1; c < alpha; ++c) {
+                int mid = next[u * alpha + c];
+                if (mid == -1 || !is_tree_edge(u, c, mid) || class_byte[c] < 0xC2) continue;
+                for (int c2 = 1; c2 < alpha; ++c2) {
+                    int w = next[mid * alpha + c2];
+                    if (w == -1 || !is_tree_edge(mid, c2, w) || class_byte[c2] == 0) continue;
+
+                    // ребра u -> mid -> w утворюють двобайтовий символ
+                    char pair_bytes_raw[2] = {(char)class_byte[c], (char)class_byte[c2]};
+                    string pair_bytes(pair_bytes_raw, 2);
+                    for_each_upper_form(pair_bytes, [&](uint32_t, uint32_t upper) {
+                        unsigned char bytes[2];
+                        encode_utf8_2(upper, bytes);
+                        int uc = byte_class[bytes[0]], uc2 = byte_class[bytes[1]];
+                        int alt = next[u * alpha + uc];
+                        if (alt == -1) {
+                            alt = (int)trie.size();
+                            next[u * alpha + uc] = alt;
+                            trie.emplace_back();
+                            next.resize(next.size() + alpha, -1);
+                            parent.push_back(u);
+                            parent_class.push_back(uc);
+                        }
+                        if (next[alt * alpha + uc2] == -1) next[alt * alpha + uc2] = w;
+                    });
+                }
+            }
+        }
+    }
 
     queue<int> q;
     trie[0].link = 0;
 
     // встановлюємо посилання для кожного переходу з кореня
-    for (int c = 0; c < AhoNode::ALPHA; ++c) {
-        int to = trie[0].next[c];
-        if (to != -1) {
+    for (int c = 0; c < alpha; ++c) {
+        int to = next[c];
+        if (to != -1 && is_tree_edge(0, c, to)) {
             trie[to].link = 0;
             q.push(to);
-        } else {
-            trie[0].next[c] = 0;
+        } else if (to == -1) {
+            next[c] = 0;
         }
     }
 
@@ -124,18 +503,68 @@ void AhoCorasick::build_automaton(const vector<string> &patterns_) {
             trie[v].out.push_back(pattern_idx);
         }
 
-        for (int c = 0; c < AhoNode::ALPHA; ++c) {
-            int to = trie[v].next[c];
-            if (to != -1) {
-                trie[to].link = trie[link].next[c];
+        for (int c = 0; c < alpha; ++c) {
+            int to = next[v * alpha + c];
+            if (to == -1) {
+                next[v * alpha + c] = next[link * alpha + c];
+            } else if (is_tree_edge(v, c, to)) {
+                trie[to].link = next[link * alpha + c];
                 q.push(to);
-            } else {
-                trie[v].next[c] = trie[link].next[c];
             }
         }
     }
 }
 
+/**
+ * @brief Доступ до переходів і виходів AhoCorasick для scan_loop.
+ *
+ * Вказівники на масиви автомата виносяться сюди один раз перед циклом.
+ */
+struct TrieAccess {
+    const int *delta;             ///< Переходи.
+    const unsigned short *cls;    ///< Класи байтів.
+    const AhoNode *nodes;         ///< Вершини.
+    const int *len;               ///< Довжини шаблонів.
+    int alpha;                    ///< Кількість класів.
+    Scope scope;                  ///< Семантика меж збігу.
+
+    explicit TrieAccess(const AhoCorasick &aho)
+        : delta(aho.next.data()), cls(aho.byte_class), nodes(aho.trie.data()),
+          len(aho.pattern_len.data()), alpha(aho.alpha), scope(aho.options.scope) {}
+
+    int step(int v, unsigned char c) const { return delta[v * alpha + cls[c]]; }
+    const int *out_begin(int v) const { return nodes[v].out.data(); }
+    const int *out_end(int v) const { return nodes[v].out.data() + nodes[v].out.size(); }
+    int pattern_len(int idx) const { return len[idx]; }
+};
+
+/**
+ * @brief Сканування діапазону тексту автоматом для всіх видів результату.
+ *
+ * Обгортка над scan_loop: сканування починається з кореня. Якщо діапазон
+ * починається посеред слова, це слово не може бути цілим збігом; якщо він
+ * закінчується посеред слова, останнє слово не перевіряється.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param from Позиція початку сканування (з кореня автомата).
+ * @param count_from Перша позиція кінця збігу, про яку повідомляється.
+ * @param to Позиція кінця сканування (не включно).
+ * @param on_match Викликається як on_match(кінець, індекс) для кожного збігу,
+ *        де кінець — позиція останнього байта; false зупиняє сканування.
+ * @return Кількість збігів, переданих обробнику.
+ */
+template <typename OnMatch>
+static size_t scan_matches(const AhoCorasick &aho, const string &text,
+                           size_t from, size_t count_from, size_t to, OnMatch on_match) {
+    const char *bytes = text.data();
+    // довжина поточного слова; слово, розпочате до from, не може збігтися
+    const size_t broken = (size_t)-1 / 2;
+    ScanState st = {0, from > 0 && is_word_byte(bytes[from - 1]) ? broken : 0};
+    bool word_ends = to == text.size() || !is_word_byte(bytes[to]);
+    return scan_loop(TrieAccess(aho), bytes, from, count_from, to, word_ends, st, on_match);
+}
+
 /**
  * @brief Пошук шаблонів в тексті за допомогою автомата Ахо–Корасіка.
  *
@@ -148,23 +577,1264 @@ void AhoCorasick::build_automaton(const vector<string> &patterns_) {
  */
 size_t AhoCorasick::search(const string &text, vector<size_t> &per_pattern) const {
     per_pattern.assign(patterns.size(), 0);
+    return accumulate(text, per_pattern.data());
+}
+
+/**
+ * @brief Пошук із розрідженим результатом.
+ *
+ * Індекс шаблону потрапляє в touched при першому збігу, тому наступний
+ * reset() обнулить рівно ті лічильники, які було змінено.
+ *
+ * @param text Текст для пошуку.
+ * @param result Розріджений результат.
+ * @return Загальна кількість входжень усіх шаблонів.
+ */
+size_t AhoCorasick::search(const string &text, SparseCounts &result) const {
+    result.reset(patterns.size());
+    size_t *counts = result.counts.data();
+    size_t total_matches = scan_matches(*this, text, 0, 0, text.size(), [&](size_t, int pattern_idx) {
+        if (counts[pattern_idx]++ == 0) result.touched.push_back(pattern_idx);
+        return true;
+    });
+
+    result.total = total_matches;
+    return total_matches;
+}
+
+/**
+ * @brief Пошук у тексті, розбитому на записи.
+ *
+ * Один розріджений результат перевикористовується для всіх записів,
+ * тому вартість запису пропорційна його довжині та кількості збігів.
+ *
+ * @param text Текст із записами.
+ * @param on_record Обробник результату кожного запису.
+ * @return Загальна кількість входжень.
+ */
+size_t AhoCorasick::search_records(const string &text, const RecordCallback &on_record) const {
+    SparseCounts hits;
+    hits.reset(patterns.size());
     size_t total_matches = 0;
-    int v = 0;
 
-    for (char ch : text) {
-        int id = char_id(ch);
-        if (id == -1) {
-            v = 0; // не літера — повертаємось у корінь
-            continue;
+    const char *base = text.data();
+    const char *end = base + text.size();
+    const char *p = base;
+    size_t record = 0;
+
+    while (p < end) {
+        const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+        const char *line_end = nl ? nl : end;
+
+        hits.reset(patterns.size());
+        size_t *counts = hits.counts.data();
+        size_t from = p - base;
+        hits.total = scan_matches(*this, text, from, from, line_end - base, [&](size_t, int pattern_idx) {
+            if (counts[pattern_idx]++ == 0) hits.touched.push_back(pattern_idx);
+            return true;
+        });
+
+        total_matches += hits.total;
+        on_record(record++, p - base, line_end - base, hits);
+        p = line_end + 1;
+    }
+
+    return total_matches;
+}
+
+/**
+ * @brief Перевірка наявності хоча б одного збігу.
+ *
+ * @param text Текст для пошуку.
+ * @return true, якщо знайдено збіг.
+ */
+bool AhoCorasick::contains_any(const string &text) const {
+    Match m;
+    return first_match(text, m);
+}
+
+/**
+ * @brief Пошук першого збігу з ранньою зупинкою.
+ *
+ * Вихідні шаблони вершини впорядковані від найдовшого (власного) до
+ * коротших, успадкованих через суфіксні посилання, тому береться перший.
+ *
+ * @param text Текст для пошуку.
+ * @param match Знайдений збіг.
+ * @return true, якщо збіг знайдено.
+ */
+bool AhoCorasick::first_match(const string &text, Match &match) const {
+    return scan_matches(*this, text, 0, 0, text.size(), [&](size_t end, int pattern_idx) {
+        match.len = pattern_len[pattern_idx];
+        match.pos = end + 1 - match.len;
+        match.pattern = pattern_idx;
+        return false;
+    }) != 0;
+}
+
+/**
+ * @brief Пошук збігів із заданою політикою перекриття.
+ *
+ * Для лівобічних режимів кандидат замінюється збігом, що починається
+ * лівіше або, з того самого початку, кращий за правилом режиму. Збіги,
+ * що починаються раніше за кінець останнього повідомленого збігу,
+ * ігноруються. Відкинуті кандидати, що починаються пізніше за поточного,
+ * запам'ятовуються лише найбільшою позицією початку — цього достатньо,
+ * щоб вирішити, чи потрібне повторне сканування.
+ *
+ * @param text Текст для пошуку.
+ * @param kind Політика перекриття.
+ * @param on_match Обробник кожного збігу.
+ * @return Кількість повідомлених збігів.
+ */
+size_t AhoCorasick::find_matches(const string &text, MatchKind kind, const MatchCallback &on_match) const {
+    size_t reported = 0;
+    size_t next_start = 0; // збіги мають починатися не раніше
+
+    if (kind == MatchKind::Overlapping || kind == MatchKind::NonOverlapping) {
+        bool overlapping = kind == MatchKind::Overlapping;
+        scan_matches(*this, text, 0, 0, text.size(), [&](size_t end, int pattern_idx) {
+            Match m = {end + 1 - pattern_len[pattern_idx], (size_t)pattern_len[pattern_idx], pattern_idx};
+            if (m.pos < next_start) return true;
+            on_match(m);
+            ++reported;
+            if (!overlapping) next_start = end + 1;
+            return true;
+        });
+        return reported;
+    }
+
+    bool longest = kind == MatchKind::LeftmostLongest;
+    auto better = [&](const Match &a, const Match &b) {
+        if (a.pos != b.pos) return a.pos < b.pos;
+        if (longest && a.len != b.len) return a.len > b.len;
+        return a.pattern < b.pattern;
+    };
+
+    bool have = false, dropped = false, restart = true;
+    Match cand = {0, 0, -1};
+    size_t dropped_pos = 0; // найбільший початок відкинутого збігу
+    auto report = [&]() {
+        on_match(cand);
+        ++reported;
+        have = false;
+        next_start = cand.pos + cand.len;
+        // відкинутий збіг після кандидата міг бути частиною відповіді
+        restart = dropped && dropped_pos >= next_start;
+        dropped = false;
+    };
+    auto consider = [&](size_t end, int pattern_idx) {
+        Match m = {end + 1 - pattern_len[pattern_idx], (size_t)pattern_len[pattern_idx], pattern_idx};
+        if (m.pos < next_start) return true;
+        if (have && end + 1 > cand.pos + max_len) {
+            // жоден наступний збіг не почнеться не пізніше за кандидата
+            report();
+            if (restart) return false;
+            if (m.pos < next_start) return true;
+        }
+        if (!have) {
+            cand = m;
+            have = true;
+            return true;
         }
-        v = trie[v].next[id];
+        Match worse = m;
+        if (better(m, cand)) swap(worse, cand);
+        dropped_pos = dropped ? max(dropped_pos, worse.pos) : worse.pos;
+        dropped = true;
+        return true;
+    };
+
+    while (restart) {
+        restart = false;
+        scan_matches(*this, text, next_start, next_start, text.size(), consider);
+        if (!restart && have) report();
+    }
+
+    return reported;
+}
 
-        // усі патерни, що закінчуються в цій вершині
-        for (int pattern_idx : trie[v].out) {
-            ++per_pattern[pattern_idx];
-            ++total_matches;
+/**
+ * @brief Перевірка порогу кількості входжень для всіх шаблонів.
+ *
+ * Для k == 1 достатньо бітсету досягнутих шаблонів; для більших порогів
+ * додатково ведуться лічильники. Сканування зупиняється, коли кількість
+ * недосягнутих шаблонів падає до нуля.
+ *
+ * @param text Текст для пошуку.
+ * @param k Поріг кількості входжень.
+ * @return true, якщо кожен шаблон зустрічається щонайменше k разів.
+ */
+bool AhoCorasick::all_reach(const string &text, size_t k) const {
+    if (k == 0) return true;
+    for (int len : pattern_len) {
+        if (len == 0) return false;
+    }
+
+    size_t remaining = patterns.size();
+    if (remaining == 0) return true;
+
+    vector<uint64_t> reached((patterns.size() + 63) / 64, 0);
+    vector<size_t> counts;
+    if (k > 1) counts.assign(patterns.size(), 0);
+
+    scan_matches(*this, text, 0, 0, text.size(), [&](size_t, int pattern_idx) {
+        uint64_t bit = uint64_t(1) << (pattern_idx & 63);
+        uint64_t &word = reached[pattern_idx >> 6];
+        if (word & bit) return true;
+        if (k > 1 && ++counts[pattern_idx] < k) return true;
+        word |= bit;
+        return --remaining != 0;
+    });
+    return remaining == 0;
+}
+
+/**
+ * @brief Сканує діапазон тексту і рахує збіги, що закінчуються не раніше count_from.
+ *
+ * Сканування завжди починається з кореня автомата в позиції from.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param from Позиція початку сканування.
+ * @param count_from Перша позиція, збіги з кінцем у якій враховуються.
+ * @param to Позиція кінця сканування (не включно).
+ * @param counts Лічильники, до яких додаються входження.
+ * @return Кількість врахованих входжень.
+ */
+static size_t scan_range(const AhoCorasick &aho, const string &text,
+                         size_t from, size_t count_from, size_t to,
+                         size_t *counts) {
+    return scan_matches(aho, text, from, count_from, to, [&](size_t, int pattern_idx) {
+        ++counts[pattern_idx];
+        return true;
+    });
+}
+
+/**
+ * @brief Пошук із накопиченням у наявні лічильники.
+ *
+ * @param text Текст для пошуку.
+ * @param counts Лічильники, до яких додаються входження.
+ * @return Кількість входжень, знайдених у цьому тексті.
+ */
+size_t AhoCorasick::accumulate(const string &text, size_t *counts) const {
+    return scan_range(*this, text, 0, 0, text.size(), counts);
+}
+
+/**
+ * @brief Створює набір вирівняних блоків лічильників.
+ *
+ * Кожен блок містить n_patterns лічильників і загальну суму, а його довжина
+ * округлюється вгору до цілої кількості кеш-ліній.
+ *
+ * @param workers Кількість обробників.
+ * @param patterns Кількість шаблонів.
+ */
+ThreadCounters::ThreadCounters(size_t workers, size_t patterns)
+    : n_workers(workers), n_patterns(patterns) {
+    const size_t per_line = CACHE_LINE / sizeof(size_t);
+    stride = (n_patterns + 1 + per_line - 1) / per_line * per_line;
+    storage.assign(stride * n_workers + per_line, 0);
+
+    uintptr_t addr = reinterpret_cast<uintptr_t>(storage.data());
+    offset = (CACHE_LINE - addr % CACHE_LINE) % CACHE_LINE / sizeof(size_t);
+}
+
+/**
+ * @brief Повертає блок лічильників обробника.
+ * @param worker Номер обробника.
+ * @return Вказівник на початок блоку.
+ */
+size_t *ThreadCounters::block(size_t worker) {
+    return storage.data() + offset + worker * stride;
+}
+
+/**
+ * @brief Повертає загальну кількість збігів обробника.
+ * @param worker Номер обробника.
+ * @return Посилання на останній елемент блоку.
+ */
+size_t &ThreadCounters::total(size_t worker) {
+    return block(worker)[n_patterns];
+}
+
+/**
+ * @brief Деревоподібне злиття блоків.
+ *
+ * Кожен потік відповідає за власну смугу стовпців (разом із загальною
+ * сумою в останньому стовпці) і виконує в ній усі рівні редукції.
+ *
+ * @param per_pattern Вектор для підсумкових кількостей.
+ * @param threads Кількість потоків для злиття.
+ * @return Загальна кількість входжень.
+ */
+size_t ThreadCounters::merge(vector<size_t> &per_pattern, unsigned threads) {
+    if (n_workers == 0) {
+        per_pattern.assign(n_patterns, 0);
+        return 0;
+    }
+
+    const size_t per_line = CACHE_LINE / sizeof(size_t);
+    const size_t columns = n_patterns + 1;
+    size_t lines = (columns + per_line - 1) / per_line;
+    if (threads == 0) threads = 1;
+    if (threads > lines) threads = (unsigned)lines;
+    size_t lines_per_thread = (lines + threads - 1) / threads;
+
+    auto reduce = [&](size_t col_begin, size_t col_end) {
+        for (size_t step = 1; step < n_workers; step *= 2) {
+            for (size_t w = 0; w + step < n_workers; w += 2 * step) {
+                size_t *dst = block(w);
+                const size_t *src = block(w + step);
+                for (size_t c = col_begin; c < col_end; ++c) dst[c] += src[c];
+            }
         }
+    };
+
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t b = min(columns, t * lines_per_thread * per_line);
+        size_t e = min(columns, (t + 1) * lines_per_thread * per_line);
+        if (b < e) pool.emplace_back(reduce, b, e);
     }
+    reduce(0, min(columns, lines_per_thread * per_line));
+    for (thread &th : pool) th.join();
 
-    return total_matches;
+    const size_t *sum = block(0);
+    per_pattern.assign(sum, sum + n_patterns);
+    return sum[n_patterns];
+}
+
+/**
+ * @brief Паралельний пошук автоматом Ахо–Корасіка.
+ *
+ * Частини тексту перекриваються на довжину найдовшого шаблону мінус один,
+ * а кожен збіг враховується лише тим потоком, у чиїй частині він закінчується.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param per_pattern Вектор для кількостей входжень.
+ * @param workers Кількість потоків.
+ * @return Загальна кількість входжень.
+ */
+size_t parallel_search(const AhoCorasick &aho,
+                       const string &text,
+                       vector<size_t> &per_pattern,
+                       unsigned workers) {
+    if (workers == 0) workers = 1;
+    if (workers > text.size()) workers = max<size_t>(1, text.size());
+
+    size_t overlap = aho.max_len > 0 ? aho.max_len - 1 : 0;
+
+    ThreadCounters counters(workers, aho.patterns.size());
+    size_t chunk = (text.size() + workers - 1) / workers;
+
+    auto work = [&](size_t w) {
+        size_t count_from = min(text.size(), w * chunk);
+        size_t to = min(text.size(), count_from + chunk);
+        size_t from = count_from > overlap ? count_from - overlap : 0;
+        counters.total(w) = scan_range(aho, text, from, count_from, to,
+                                       counters.block(w));
+    };
+
+    vector<thread> pool;
+    for (unsigned w = 1; w < workers; ++w) pool.emplace_back(work, w);
+    work(0);
+    for (thread &th : pool) th.join();
+
+    return counters.merge(per_pattern, workers);
+}
+
+/**
+ * @brief Кількість рядків матриці.
+ * @return Кількість документів.
+ */
+size_t CountMatrix::rows() const {
+    return row_offset.empty() ? 0 : row_offset.size() - 1;
+}
+
+/**
+ * @brief Пошук у багатьох документах із результатом CSR.
+ *
+ * Перша фаза: кожен потік обробляє свій діапазон документів і записує
+ * кількість ненульових елементів кожного рядка та самі елементи у власні
+ * масиви. Друга фаза: префіксна сума дає row_offset, і кожен потік
+ * копіює свої елементи, знаючи зсув першого рядка свого діапазону.
+ *
+ * @param aho Побудований автомат.
+ * @param documents Документи.
+ * @param matrix Результат.
+ * @param workers Кількість потоків.
+ * @return Загальна кількість входжень.
+ */
+size_t batch_search(const AhoCorasick &aho,
+                    const vector<string> &documents,
+                    CountMatrix &matrix,
+                    unsigned workers) {
+    size_t n = documents.size();
+    if (workers == 0) workers = 1;
+    if (workers > n) workers = max<size_t>(1, n);
+
+    // межі діапазонів за кількістю байтів
+    size_t bytes = 0;
+    for (const string &d : documents) bytes += d.size();
+    vector<size_t> first(workers + 1, n);
+    first[0] = 0;
+    size_t acc = 0, w = 1;
+    for (size_t d = 0; d < n && w < workers; ++d) {
+        acc += documents[d].size();
+        while (w < workers && acc * workers >= bytes * w) first[w++] = d + 1;
+    }
+
+    struct Part {
+        vector<int> columns;
+        vector<size_t> values;
+        size_t total = 0;
+    };
+    vector<Part> parts(workers);
+    matrix.cols = aho.patterns.size();
+    matrix.row_offset.assign(n + 1, 0);
+
+    auto scan = [&](size_t k) {
+        Part &part = parts[k];
+        SparseCounts hits;
+        for (size_t d = first[k]; d < first[k + 1]; ++d) {
+            part.total += aho.search(documents[d], hits);
+            sort(hits.touched.begin(), hits.touched.end());
+            for (int idx : hits.touched) {
+                part.columns.push_back(idx);
+                part.values.push_back(hits.counts[idx]);
+            }
+            matrix.row_offset[d + 1] = hits.touched.size();
+        }
+    };
+    auto run = [&](auto job) {
+        vector<thread> pool;
+        for (unsigned k = 1; k < workers; ++k) pool.emplace_back(job, k);
+        job(0);
+        for (thread &th : pool) th.join();
+    };
+
+    run(scan);
+    for (size_t d = 0; d < n; ++d) matrix.row_offset[d + 1] += matrix.row_offset[d];
+
+    matrix.columns.resize(matrix.row_offset[n]);
+    matrix.values.resize(matrix.row_offset[n]);
+    run([&](size_t k) {
+        size_t at = matrix.row_offset[first[k]];
+        copy(parts[k].columns.begin(), parts[k].columns.end(), matrix.columns.begin() + at);
+        copy(parts[k].values.begin(), parts[k].values.end(), matrix.values.begin() + at);
+    });
+
+    size_t total_matches = 0;
+    for (const Part &part : parts) total_matches += part.total;
+    return total_matches;
+}
+
+/**
+ * @brief Створює порожнє зведення.
+ * @param capacity_ Найбільша кількість відстежуваних шаблонів.
+ */
+TopKSummary::TopKSummary(size_t capacity_) : capacity(0), total(0) {
+    reset(capacity_);
+}
+
+/**
+ * @brief Очищає зведення.
+ * @param capacity_ Нова найбільша кількість відстежуваних шаблонів.
+ */
+void TopKSummary::reset(size_t capacity_) {
+    capacity = capacity_ ? capacity_ : 1;
+    total = 0;
+    heap.clear();
+    heap.reserve(capacity);
+    slot.clear();
+    slot.reserve(capacity);
+}
+
+/**
+ * @brief Опускає запис купи на своє місце після збільшення count.
+ * @param s Зведення.
+ * @param i Позиція запису.
+ */
+static void sift_down(TopKSummary &s, size_t i) {
+    size_t n = s.heap.size();
+    TopKEntry moving = s.heap[i];
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && s.heap[child + 1].count < s.heap[child].count) ++child;
+        if (s.heap[child].count >= moving.count) break;
+        s.heap[i] = s.heap[child];
+        s.slot[s.heap[i].pattern] = i;
+        i = child;
+    }
+    s.heap[i] = moving;
+    s.slot[moving.pattern] = i;
+}
+
+/**
+ * @brief Піднімає запис купи на своє місце після вставлення.
+ * @param s Зведення.
+ * @param i Позиція запису.
+ */
+static void sift_up(TopKSummary &s, size_t i) {
+    TopKEntry moving = s.heap[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (s.heap[parent].count <= moving.count) break;
+        s.heap[i] = s.heap[parent];
+        s.slot[s.heap[i].pattern] = i;
+        i = parent;
+    }
+    s.heap[i] = moving;
+    s.slot[moving.pattern] = i;
+}
+
+/**
+ * @brief Враховує входження шаблону за правилом Space-Saving.
+ *
+ * Кількість лише зростає, тож відстежуваний шаблон опускається в купі;
+ * витіснення замінює корінь (найрідший шаблон).
+ *
+ * @param pattern Індекс шаблону.
+ * @param weight Кількість входжень.
+ */
+void TopKSummary::add(int pattern, size_t weight) {
+    if (weight == 0) return;
+    total += weight;
+
+    auto it = slot.find(pattern);
+    if (it != slot.end()) {
+        heap[it->second].count += weight;
+        sift_down(*this, it->second);
+    } else if (heap.size() < capacity) {
+        heap.push_back({pattern, weight, 0});
+        sift_up(*this, heap.size() - 1);
+    } else {
+        size_t least = heap[0].count;
+        slot.erase(heap[0].pattern);
+        heap[0] = {pattern, least + weight, least};
+        sift_down(*this, 0);
+    }
+}
+
+/**
+ * @brief Найменша кількість невідстежуваного шаблону.
+ * @return count кореня купи для заповненого зведення, інакше 0.
+ */
+size_t TopKSummary::floor() const {
+    return heap.size() < capacity || heap.empty() ? 0 : heap[0].count;
+}
+
+/**
+ * @brief Порядок записів: більший count, за рівності — менший індекс.
+ * @param a Перший запис.
+ * @param b Другий запис.
+ * @return true, якщо a йде раніше за b.
+ */
+static bool more_frequent(const TopKEntry &a, const TopKEntry &b) {
+    if (a.count != b.count) return a.count > b.count;
+    return a.pattern < b.pattern;
+}
+
+/**
+ * @brief Об'єднує зведення двох шардів.
+ *
+ * Для кожного шаблону з об'єднання count і error — суми оцінок із обох
+ * зведень, де відсутній шаблон має floor() відповідного зведення. З
+ * об'єднання лишаються capacity найчастіших записів.
+ *
+ * @param other Зведення іншого шарду.
+ */
+void TopKSummary::merge(const TopKSummary &other) {
+    size_t own_floor = floor();
+    size_t other_floor = other.floor();
+
+    vector<TopKEntry> all;
+    all.reserve(heap.size() + other.heap.size());
+    for (const TopKEntry &e : heap) {
+        auto it = other.slot.find(e.pattern);
+        if (it != other.slot.end()) {
+            const TopKEntry &o = other.heap[it->second];
+            all.push_back({e.pattern, e.count + o.count, e.error + o.error});
+        } else {
+            all.push_back({e.pattern, e.count + other_floor, e.error + other_floor});
+        }
+    }
+    for (const TopKEntry &o : other.heap) {
+        if (slot.count(o.pattern)) continue;
+        all.push_back({o.pattern, o.count + own_floor, o.error + own_floor});
+    }
+
+    if (all.size() > capacity) {
+        nth_element(all.begin(), all.begin() + capacity, all.end(), more_frequent);
+        all.resize(capacity);
+    }
+    size_t merged_total = total + other.total;
+    reset(capacity);
+    total = merged_total;
+    for (const TopKEntry &e : all) {
+        heap.push_back(e);
+        sift_up(*this, heap.size() - 1);
+    }
+}
+
+/**
+ * @brief k найчастіших шаблонів.
+ * @param k Кількість шаблонів.
+ * @return Записи за спаданням count.
+ */
+vector<TopKEntry> TopKSummary::top(size_t k) const {
+    vector<TopKEntry> result(heap);
+    k = min(k, result.size());
+    partial_sort(result.begin(), result.begin() + k, result.end(), more_frequent);
+    result.resize(k);
+    return result;
+}
+
+/**
+ * @brief Сканування з оновленням зведення на кожному збігу.
+ * @param aho Побудований автомат.
+ * @param text Фрагмент тексту.
+ * @param summary Зведення.
+ * @return Кількість входжень у фрагменті.
+ */
+size_t accumulate_top(const AhoCorasick &aho, const string &text, TopKSummary &summary) {
+    return scan_matches(aho, text, 0, 0, text.size(), [&](size_t, int pattern_idx) {
+        summary.add(pattern_idx);
+        return true;
+    });
+}
+
+/**
+ * @brief Створює порожній ескіз.
+ * @param epsilon Допустима відносна похибка.
+ * @param delta Імовірність перевищити похибку.
+ */
+CountMinSketch::CountMinSketch(double epsilon, double delta) : width(1), depth(1), total(0) {
+    double want = epsilon > 0 ? exp(1.0) / epsilon : 1.0;
+    while ((double)width < want && width < ((size_t)1 << 40)) width <<= 1;
+    if (delta > 0 && delta < 1) depth = max<size_t>(1, (size_t)ceil(log(1.0 / delta)));
+    cells.assign(width * depth, 0);
+}
+
+/**
+ * @brief Обнуляє всі лічильники.
+ */
+void CountMinSketch::clear() {
+    fill(cells.begin(), cells.end(), 0);
+    total = 0;
+}
+
+/**
+ * @brief Перемішує біти індексу шаблону (splitmix64).
+ * @param x Значення.
+ * @return Хеш.
+ */
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Викликає f(комірка) для комірки шаблону в кожному рядку.
+ *
+ * Позиції рядків — h1 + r * h2 (подвійне хешування) з одного 64-бітного
+ * хешу; h2 непарний, тож позиції різних рядків не збігаються циклічно.
+ *
+ * @param sketch Ескіз.
+ * @param pattern Індекс шаблону.
+ * @param f Обробник індексу комірки в cells.
+ */
+template <typename F>
+static void for_each_cell(const CountMinSketch &sketch, int pattern, F f) {
+    uint64_t h = mix64((uint64_t)(uint32_t)pattern);
+    uint64_t h1 = h & 0xffffffffULL;
+    uint64_t h2 = (h >> 32) | 1;
+    size_t mask = sketch.width - 1;
+    for (size_t r = 0; r < sketch.depth; ++r) f(r * sketch.width + ((h1 + r * h2) & mask));
+}
+
+/**
+ * @brief Враховує входження шаблону.
+ * @param pattern Індекс шаблону.
+ * @param weight Кількість входжень.
+ */
+void CountMinSketch::add(int pattern, size_t weight) {
+    size_t *c = cells.data();
+    for_each_cell(*this, pattern, [&](size_t cell) { c[cell] += weight; });
+    total += weight;
+}
+
+/**
+ * @brief Оцінка кількості входжень — мінімум по рядках.
+ * @param pattern Індекс шаблону.
+ * @return Оцінка зверху.
+ */
+size_t CountMinSketch::estimate(int pattern) const {
+    size_t best = (size_t)-1;
+    for_each_cell(*this, pattern, [&](size_t cell) { best = min(best, cells[cell]); });
+    return best;
+}
+
+/**
+ * @brief Межа переоцінки e * total / width.
+ * @return Найбільша переоцінка.
+ */
+size_t CountMinSketch::error_bound() const {
+    return (size_t)ceil(exp(1.0) * (double)total / (double)width);
+}
+
+/**
+ * @brief Поелементно додає інший ескіз.
+ * @param other Ескіз тих самих розмірів.
+ * @return false, якщо розміри різні.
+ */
+bool CountMinSketch::merge(const CountMinSketch &other) {
+    if (other.width != width || other.depth != depth) return false;
+    for (size_t i = 0; i < cells.size(); ++i) cells[i] += other.cells[i];
+    total += other.total;
+    return true;
+}
+
+/**
+ * @brief Сканування з оновленням ескізу на кожному збігу.
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param sketch Ескіз.
+ * @return Кількість входжень у тексті.
+ */
+size_t accumulate_sketch(const AhoCorasick &aho, const string &text, CountMinSketch &sketch) {
+    size_t *c = sketch.cells.data();
+    size_t found = scan_matches(aho, text, 0, 0, text.size(), [&](size_t, int pattern_idx) {
+        for_each_cell(sketch, pattern_idx, [&](size_t cell) { ++c[cell]; });
+        return true;
+    });
+    sketch.total += found;
+    return found;
+}
+
+/**
+ * @brief Блок лічильників словника.
+ * @param dictionary Індекс словника.
+ * @return Вказівник на лічильник першого шаблону словника.
+ */
+const size_t *DictionaryCounts::block(size_t dictionary) const {
+    return counts.data() + offset[dictionary];
+}
+
+/**
+ * @brief Кількість шаблонів у словнику.
+ * @param dictionary Індекс словника.
+ * @return Розмір блоку.
+ */
+size_t DictionaryCounts::block_size(size_t dictionary) const {
+    return offset[dictionary + 1] - offset[dictionary];
+}
+
+/**
+ * @brief Будує об'єднаний автомат за кількома словниками.
+ *
+ * Шаблони словників записуються поспіль, тож глобальний індекс шаблону
+ * дорівнює offset[словник] + індекс у словнику.
+ *
+ * @param dictionaries Словники.
+ * @param options Семантика збігу.
+ */
+void MultiDictionary::build(const vector<Dictionary> &dictionaries, const MatchOptions &options) {
+    names.clear();
+    offset.assign(1, 0);
+    tags.clear();
+
+    vector<string> all;
+    for (size_t d = 0; d < dictionaries.size(); ++d) {
+        names.push_back(dictionaries[d].name);
+        for (size_t i = 0; i < dictionaries[d].patterns.size(); ++i) {
+            all.push_back(dictionaries[d].patterns[i]);
+            tags.push_back({(int)d, (int)i});
+        }
+        offset.push_back(all.size());
+    }
+
+    aho.build_automaton(all, options);
+}
+
+/**
+ * @brief Індекс словника за назвою.
+ * @param name Назва словника.
+ * @return Індекс або -1.
+ */
+int MultiDictionary::find(const string &name) const {
+    for (size_t d = 0; d < names.size(); ++d) {
+        if (names[d] == name) return (int)d;
+    }
+    return -1;
+}
+
+/**
+ * @brief Походження глобального індексу шаблону.
+ * @param pattern Глобальний індекс шаблону.
+ * @return Пара (словник, шаблон у словнику).
+ */
+PatternTag MultiDictionary::tag(int pattern) const {
+    return tags[pattern];
+}
+
+/**
+ * @brief Один прохід по тексту для всіх словників.
+ *
+ * Лічильники шаблонів лежать у порядку глобальних індексів, тож блоки
+ * словників заповнюються без перекладання; окремо ведеться лише сума
+ * кожного словника.
+ *
+ * @param text Текст для пошуку.
+ * @param result Лічильники по блоках словників.
+ * @return Загальна кількість входжень.
+ */
+size_t MultiDictionary::search(const string &text, DictionaryCounts &result) const {
+    result.counts.assign(tags.size(), 0);
+    result.offset = offset;
+    result.totals.assign(names.size(), 0);
+
+    size_t *counts = result.counts.data();
+    size_t *totals = result.totals.data();
+    const PatternTag *tag_of = tags.data();
+    return scan_matches(aho, text, 0, 0, text.size(), [&](size_t, int pattern_idx) {
+        ++counts[pattern_idx];
+        ++totals[tag_of[pattern_idx].dictionary];
+        return true;
+    });
+}
+
+/**
+ * @brief Однопрохідна заміна входжень шаблонів.
+ *
+ * Збіги надходять від find_matches у порядку позицій, тож між ними
+ * достатньо пам'ятати кінець попереднього збігу.
+ *
+ * @param aho Побудований автомат.
+ * @param text Вхідний текст.
+ * @param replacements Заміна для кожного шаблону.
+ * @param sink Приймач результату.
+ * @return Кількість виконаних замін.
+ */
+size_t replace_all(const AhoCorasick &aho,
+                   const string &text,
+                   const vector<string> &replacements,
+                   const WriteSink &sink) {
+    const char *base = text.data();
+    size_t copied = 0; // текст до цієї позиції вже передано
+    size_t replaced = 0;
+
+    aho.find_matches(text, MatchKind::LeftmostLongest, [&](const Match &m) {
+        if ((size_t)m.pattern >= replacements.size()) return;
+        if (m.pos > copied) sink(base + copied, m.pos - copied);
+        const string &r = replacements[m.pattern];
+        if (!r.empty()) sink(r.data(), r.size());
+        copied = m.pos + m.len;
+        ++replaced;
+    });
+    if (copied < text.size()) sink(base + copied, text.size() - copied);
+
+    return replaced;
+}
+
+/**
+ * @brief Повертає пам'ять рядка в купі (0 для короткого рядка всередині об'єкта).
+ * @param str Рядок.
+ * @return Кількість байтів у купі.
+ */
+static size_t heap_bytes(const string &str) {
+    const char *p = str.data();
+    const char *obj = reinterpret_cast<const char *>(&str);
+    if (p >= obj && p < obj + sizeof(str)) return 0;
+    return str.capacity() + 1;
+}
+
+/**
+ * @brief Повертає розмір рівня кешу через sysconf або 0, якщо він невідомий.
+ * @param name Ідентифікатор sysconf.
+ * @return Розмір у байтах.
+ */
+static size_t cache_size(int name) {
+    long v = sysconf(name);
+    return v > 0 ? (size_t)v : 0;
+}
+
+/**
+ * @brief Збирає статистику автомата.
+ * @return Звіт про автомат.
+ */
+AhoStats AhoCorasick::stats() const {
+    AhoStats st;
+    st.states = trie.size();
+    st.edges = 0;
+    st.outputs = 0;
+
+    st.node_bytes = trie.capacity() * sizeof(AhoNode);
+    st.transition_bytes = next.capacity() * sizeof(int) + sizeof(byte_class);
+    st.output_bytes = 0;
+    for (const AhoNode &node : trie) {
+        st.output_bytes += node.out.capacity() * sizeof(int);
+        st.outputs += node.out.size();
+    }
+    st.pattern_bytes = patterns.capacity() * sizeof(string);
+    for (const string &p : patterns) st.pattern_bytes += heap_bytes(p);
+    st.aux_bytes = pattern_len.capacity() * sizeof(int);
+    st.total_bytes = sizeof(*this) - sizeof(byte_class) + st.node_bytes + st.transition_bytes + st.output_bytes +
+                     st.pattern_bytes + st.aux_bytes;
+    st.hot_bytes = st.node_bytes + st.transition_bytes + st.output_bytes;
+
+    // глибина — відстань від кореня в обході в ширину
+    vector<int> depth(trie.size(), -1);
+    queue<int> q;
+    depth[0] = 0;
+    q.push(0);
+    while (!q.empty()) {
+        int v = q.front(); q.pop();
+        for (int c = 0; c < alpha; ++c) {
+            int to = next[v * alpha + c];
+            if (to <= 0 || depth[to] != -1) continue;
+            depth[to] = depth[v] + 1;
+            q.push(to);
+        }
+    }
+
+    for (size_t v = 0; v < trie.size(); ++v) {
+        size_t children = 0;
+        for (int c = 0; c < alpha; ++c) {
+            int to = next[v * alpha + c];
+            if (to > 0 && depth[to] == depth[v] + 1) ++children;
+        }
+        st.edges += children;
+
+        size_t d = depth[v] < 0 ? 0 : (size_t)depth[v];
+        if (st.depth_histogram.size() <= d) st.depth_histogram.resize(d + 1, 0);
+        ++st.depth_histogram[d];
+        if (st.fanout_histogram.size() <= children) st.fanout_histogram.resize(children + 1, 0);
+        ++st.fanout_histogram[children];
+        size_t outs = trie[v].out.size();
+        if (st.output_histogram.size() <= outs) st.output_histogram.resize(outs + 1, 0);
+        ++st.output_histogram[outs];
+    }
+
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    st.l1_bytes = cache_size(_SC_LEVEL1_DCACHE_SIZE);
+    st.l2_bytes = cache_size(_SC_LEVEL2_CACHE_SIZE);
+    st.llc_bytes = cache_size(_SC_LEVEL3_CACHE_SIZE);
+    if (st.llc_bytes == 0) st.llc_bytes = st.l2_bytes;
+#else
+    st.l1_bytes = st.l2_bytes = st.llc_bytes = 0;
+#endif
+
+    if (st.l1_bytes == 0 && st.l2_bytes == 0 && st.llc_bytes == 0) st.residency = "unknown";
+    else if (st.hot_bytes <= st.l1_bytes) st.residency = "L1";
+    else if (st.hot_bytes <= st.l2_bytes) st.residency = "L2";
+    else if (st.hot_bytes <= st.llc_bytes) st.residency = "LLC";
+    else st.residency = "DRAM";
+
+    return st;
+}
+
+/**
+ * @brief Друкує непорожні кошики гістограми в один рядок.
+ *
+ * @param os Потік виводу.
+ * @param hist Гістограма.
+ */
+static void print_histogram(ostream &os, const vector<size_t> &hist) {
+    bool first = true;
+    for (size_t i = 0; i < hist.size(); ++i) {
+        if (hist[i] == 0) continue;
+        os << (first ? "" : " ") << i << ":" << hist[i];
+        first = false;
+    }
+    os << "\n";
+}
+
+/**
+ * @brief Друкує звіт про автомат.
+ *
+ * @param os Потік виводу.
+ * @param st Звіт.
+ * @param indent Відступ рядків.
+ */
+void print_stats(ostream &os, const AhoStats &st, const char *indent) {
+    os << indent << "States:        " << st.states << " (" << st.edges << " trie edges, "
+       << st.outputs << " outputs)\n";
+    os << indent << "Memory:        " << st.total_bytes << " bytes total\n";
+    os << indent << "  nodes:       " << st.node_bytes << " bytes\n";
+    os << indent << "  transitions: " << st.transition_bytes << " bytes\n";
+    os << indent << "  outputs:     " << st.output_bytes << " bytes\n";
+    os << indent << "  patterns:    " << st.pattern_bytes << " bytes\n";
+    os << indent << "  auxiliary:   " << st.aux_bytes << " bytes\n";
+    os << indent << "Hot set:       " << st.hot_bytes << " bytes, ";
+    if (st.residency == "unknown") os << "cache sizes unavailable\n";
+    else os << "fits in " << st.residency << " (L1 " << st.l1_bytes << ", L2 " << st.l2_bytes
+            << ", LLC " << st.llc_bytes << ")\n";
+    os << indent << "Depth:         ";
+    print_histogram(os, st.depth_histogram);
+    os << indent << "Fan-out:       ";
+    print_histogram(os, st.fanout_histogram);
+    os << indent << "Output length: ";
+    print_histogram(os, st.output_histogram);
+}
+
+/**
+ * @brief Рахує символи '\n' по 8 байтів за крок.
+ *
+ * Для байта b слова w ^ 0x0a..0a старший біт ((b & 0x7f) + 0x7f) | b
+ * встановлено тоді й лише тоді, коли b ненульовий; сума в межах байта
+ * не перевищує 0xfe, тож переносів між байтами немає. Позначки
+ * накопичуються по байтах (не довше 255 слів) і підсумовуються через
+ * 16-бітні лінії множенням на 0x0001..0001.
+ *
+ * @param data Байти.
+ * @param size Кількість байтів.
+ * @return Кількість символів '\n'.
+ */
+size_t count_newlines(const char *data, size_t size) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t low7 = 0x7f7f7f7f7f7f7f7fULL;
+    const uint64_t high = 0x8080808080808080ULL;
+    size_t lines = 0;
+    size_t i = 0;
+    while (i + 8 <= size) {
+        // до 255 слів: кожен байт lanes рахує свої '\n' без переповнення
+        size_t words = min<size_t>((size - i) / 8, 255);
+        uint64_t lanes = 0;
+        for (size_t k = 0; k < words; ++k, i += 8) {
+            uint64_t w;
+            memcpy(&w, data + i, 8);
+            w ^= ones * '\n';
+            uint64_t nonzero = ((w & low7) + low7) | w;
+            lanes += (~nonzero & high) >> 7;
+        }
+        // байти lanes — до 255 кожен, їхня сума — до 2040: спершу пари
+        // байтів складаються в 16-бітні лінії, щоб сума не обрізалася до 8 бітів
+        const uint64_t even = 0x00ff00ff00ff00ffULL;
+        uint64_t pairs = (lanes & even) + ((lanes >> 8) & even);
+        lines += (size_t)((pairs * 0x0001000100010001ULL) >> 48);
+    }
+    for (; i < size; ++i) lines += data[i] == '\n';
+    return lines;
+}
+
+/**
+ * @brief Створює курсор на початку тексту.
+ * @param text_ Текст.
+ */
+LineCursor::LineCursor(const string &text_)
+    : text(text_.data()), size(text_.size()), pos(0), line(1), line_start(0) {}
+
+/**
+ * @brief Рядок і стовпець позиції.
+ *
+ * Уперед: символи '\n' між попередньою і новою позицією рахуються
+ * блоками, а початок рядка шукається назад від нової позиції лише тоді,
+ * коли між ними був хоча б один '\n'. Назад: кількість '\n' віднімається,
+ * а початок рядка шукається назад від нової позиції.
+ *
+ * @param offset Позиція в тексті.
+ * @return Рядок і стовпець.
+ */
+LineColumn LineCursor::locate(size_t offset) {
+    if (offset > size) offset = size;
+    if (offset >= pos) {
+        size_t crossed = count_newlines(text + pos, offset - pos);
+        if (crossed) {
+            line += crossed;
+            size_t i = offset;
+            while (text[i - 1] != '\n') --i;
+            line_start = i;
+        }
+    } else {
+        line -= count_newlines(text + offset, pos - offset);
+        size_t i = offset;
+        while (i > 0 && text[i - 1] != '\n') --i;
+        line_start = i;
+    }
+    pos = offset;
+    return {line, offset - line_start + 1};
+}
+
+/**
+ * @brief find_matches із рядком і стовпцем кожного збігу.
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param kind Політика перекриття.
+ * @param on_match Обробник кожного збігу.
+ * @return Кількість повідомлених збігів.
+ */
+size_t find_located(const AhoCorasick &aho,
+                    const string &text,
+                    MatchKind kind,
+                    const LocatedMatchCallback &on_match) {
+    LineCursor cursor(text);
+    return aho.find_matches(text, kind, [&](const Match &m) {
+        on_match(m, cursor.locate(m.pos));
+    });
+}
+
+/**
+ * @brief Перевіряє, чи є байт продовженням символу UTF-8.
+ * @param c Байт.
+ * @return true для 0x80..0xBF.
+ */
+static bool is_continuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Збіг із контекстом у межах тексту, символів і, за потреби, рядка.
+ *
+ * Пошук меж рядка обмежений самим контекстом, тож вартість не залежить
+ * від довжини рядка.
+ *
+ * @param text Текст.
+ * @param pos Позиція збігу.
+ * @param len Довжина збігу.
+ * @param context Байтів контексту з кожного боку.
+ * @param clamp Межі контексту.
+ * @return Фрагмент.
+ */
+string_view snippet_around(string_view text, size_t pos, size_t len, size_t context, SnippetClamp clamp) {
+    size_t end = pos + len;
+    size_t begin = pos > context ? pos - context : 0;
+    size_t stop = text.size() - end > context ? end + context : text.size();
+
+    if (clamp == SnippetClamp::Line) {
+        for (size_t i = pos; i > begin; --i) {
+            if (text[i - 1] == '\n') {
+                begin = i;
+                break;
+            }
+        }
+        const void *nl = memchr(text.data() + end, '\n', stop - end);
+        if (nl) {
+            stop = static_cast<const char *>(nl) - text.data();
+            if (stop > end && text[stop - 1] == '\r') --stop;
+        }
+    }
+    while (begin < pos && is_continuation((unsigned char)text[begin])) ++begin;
+    while (stop > end && stop < text.size() && is_continuation((unsigned char)text[stop])) --stop;
+
+    return text.substr(begin, stop - begin);
+}
+
+/**
+ * @brief Групує збіги у фрагменти.
+ *
+ * Поточний фрагмент розширюється, доки фрагмент наступного збігу його
+ * перекриває або стикається з ним; інакше поточний передається обробнику.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param kind Політика перекриття.
+ * @param context Байтів контексту з кожного боку.
+ * @param clamp Межі контексту.
+ * @param on_snippet Обробник фрагмента.
+ * @return Кількість фрагментів.
+ */
+size_t find_snippets(const AhoCorasick &aho,
+                     const string &text,
+                     MatchKind kind,
+                     size_t context,
+                     SnippetClamp clamp,
+                     const SnippetCallback &on_snippet) {
+    string_view all(text);
+    LineCursor cursor(text);
+    vector<Match> matches;
+    size_t begin = 0, end = 0;
+    size_t snippets = 0;
+
+    auto emit = [&]() {
+        Snippet sn = {all.substr(begin, end - begin), begin, cursor.locate(begin)};
+        on_snippet(sn, matches);
+        matches.clear();
+        ++snippets;
+    };
+
+    aho.find_matches(text, kind, [&](const Match &m) {
+        string_view sv = snippet_around(all, m.pos, m.len, context, clamp);
+        size_t b = sv.data() - text.data();
+        size_t e = b + sv.size();
+        if (!matches.empty() && b <= end && e >= begin) {
+            begin = min(begin, b);
+            end = max(end, e);
+        } else {
+            if (!matches.empty()) emit();
+            begin = b;
+            end = e;
+        }
+        matches.push_back(m);
+    });
+    if (!matches.empty()) emit();
+
+    return snippets;
+}
+
+/**
+ * @brief Створює сканер на початку потоку.
+ * @param aho_ Побудований автомат.
+ */
+StreamScanner::StreamScanner(const AhoCorasick &aho_) : aho(&aho_), state(0), word_len(0), consumed(0) {}
+
+/**
+ * @brief Повертає сканер на початок потоку.
+ */
+void StreamScanner::reset() {
+    state = 0;
+    word_len = 0;
+    consumed = 0;
+}
+
+/**
+ * @brief Сканує наступний фрагмент, продовжуючи зі стану попереднього.
+ *
+ * Той самий scan_loop, що й для суцільного тексту; вершина й довжина слова
+ * беруться зі сканера та повертаються в нього, а слово на кінці фрагмента
+ * лишається незавершеним.
+ *
+ * @param data Байти фрагмента.
+ * @param size Кількість байтів.
+ * @param hits Розріджений результат.
+ * @return Кількість входжень у фрагменті.
+ */
+size_t StreamScanner::feed(const char *data, size_t size, SparseCounts &hits) {
+    if (hits.counts.size() < aho->patterns.size()) hits.counts.resize(aho->patterns.size(), 0);
+    size_t *counts = hits.counts.data();
+    ScanState st = {state, word_len};
+    size_t found = scan_loop(TrieAccess(*aho), data, 0, 0, size, false, st, [&](size_t, int pattern_idx) {
+        if (counts[pattern_idx]++ == 0) hits.touched.push_back(pattern_idx);
+        return true;
+    });
+
+    state = st.state;
+    word_len = st.word_len;
+    consumed += size;
+    hits.total += found;
+    return found;
+}
+
+/**
+ * @brief Завершує потік.
+ * @param hits Розріджений результат.
+ * @return Кількість входжень, знайдених в останньому слові.
+ */
+size_t StreamScanner::finish(SparseCounts &hits) {
+    if (hits.counts.size() < aho->patterns.size()) hits.counts.resize(aho->patterns.size(), 0);
+    size_t *counts = hits.counts.data();
+    ScanState st = {state, word_len};
+    // порожній діапазон: лише перевірка незавершеного слова
+    size_t found = scan_loop(TrieAccess(*aho), nullptr, 0, 0, 0, true, st, [&](size_t, int pattern_idx) {
+        if (counts[pattern_idx]++ == 0) hits.touched.push_back(pattern_idx);
+        return true;
+    });
+    hits.total += found;
+    reset();
+    return found;
 }
@@ -1,7 +1,58 @@
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+/**
+ * @brief Врахування регістру під час порівняння.
+ */
+enum class CaseMode {
+    Sensitive,  ///< Байти порівнюються як є.
+    AsciiFold,  ///< Латинські літери A..Z і a..z вважаються однаковими.
+    UnicodeFold ///< Як AsciiFold, а також проста згортка регістру латиниці й кирилиці в UTF-8.
+};
+
+/**
+ * @brief Де може розташовуватися збіг.
+ */
+enum class Scope {
+    Substring, ///< Будь-який підрядок тексту, зокрема через пробіли й розділові знаки.
+    WithinWord, ///< Лише всередині слова; не-літери в шаблоні пропускаються.
+    WholeWord   ///< Лише ціле слово, обмежене не-літерами або краями тексту.
+};
+
+/**
+ * @brief Семантика збігу, однакова для всіх рушіїв пошуку.
+ *
+ * За однакових MatchOptions naive_search і AhoCorasick повертають однакові
+ * результати, тому рушії можна заміняти один одним. Позиції збігів завжди
+ * відповідають байтам вихідного тексту.
+ *
+ * Словом вважається послідовність латинських літер і байтів багатобайтових
+ * символів UTF-8 (0x80 і більше), тож кириличні слова не розриваються.
+ * Згортка регістру зберігає довжину кожного символу в байтах.
+ */
+struct MatchOptions {
+    CaseMode case_mode = CaseMode::Sensitive; ///< Врахування регістру.
+    Scope scope = Scope::Substring;           ///< Межі збігу.
+};
+
+/**
+ * @brief Перевіряє, чи належить байт слову.
+ *
+ * Визначено в заголовку, щоб цикли пошуку в інших модулях вбудовували перевірку.
+ *
+ * @param c Байт.
+ * @return true для A..Z, a..z та байтів багатобайтових символів UTF-8.
+ */
+inline bool is_word_byte(unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26 || c >= 0x80;
+}
+
 /**
  * @brief Виконує наївний пошук набору шаблонів у тексті.
  *
@@ -12,40 +63,228 @@
  * @param text Вхідний текст, у якому виконується пошук.
  * @param patterns Набір слів (шаблонів), які потрібно знайти.
  * @param per_pattern Вектор, у який записується кількість входжень кожного шаблону.
+ * @param options Семантика збігу (за замовчуванням — точний підрядок).
  * @return Загальна кількість входжень усіх шаблонів у тексті.
  */
 size_t naive_search(const std::string &text,
                     const std::vector<std::string> &patterns,
-                    std::vector<size_t> &per_pattern);
+                    std::vector<size_t> &per_pattern,
+                    const MatchOptions &options = MatchOptions());
+
+/**
+ * @brief Розріджений результат пошуку для великих словників і коротких текстів.
+ *
+ * Щільний масив counts виділяється один раз і надалі лише перевикористовується:
+ * reset() обнуляє тільки ті елементи, які були зачеплені попереднім пошуком
+ * (їхні індекси зберігаються в touched). Тому вартість пошуку в короткому
+ * рядку не залежить від розміру словника.
+ */
+struct SparseCounts {
+    std::vector<size_t> counts; ///< Кількість входжень кожного шаблону (нулі поза touched).
+    std::vector<int> touched;   ///< Індекси шаблонів із ненульовою кількістю, у порядку першого збігу.
+    size_t total;               ///< Загальна кількість входжень.
+
+    /**
+     * @brief Створює порожній результат.
+     */
+    SparseCounts();
+
+    /**
+     * @brief Готує результат до нового пошуку.
+     *
+     * Обнуляє лише зачеплені лічильники; масив counts розширюється,
+     * якщо шаблонів стало більше.
+     *
+     * @param n_patterns Кількість шаблонів у словнику.
+     */
+    void reset(size_t n_patterns);
+
+    /**
+     * @brief Повертає кількість входжень шаблону.
+     * @param idx Індекс шаблону.
+     * @return Кількість входжень або 0, якщо індекс поза межами.
+     */
+    size_t count(int idx) const;
+};
+
+/**
+ * @brief Наївний пошук із розрідженим результатом.
+ *
+ * @param text Вхідний текст, у якому виконується пошук.
+ * @param patterns Набір слів (шаблонів), які потрібно знайти.
+ * @param result Розріджений результат; попередній вміст скидається через reset().
+ * @param options Семантика збігу.
+ * @return Загальна кількість входжень усіх шаблонів у тексті.
+ */
+size_t naive_search(const std::string &text,
+                    const std::vector<std::string> &patterns,
+                    SparseCounts &result,
+                    const MatchOptions &options = MatchOptions());
+
+/**
+ * @brief Наївний пошук, що додає збіги до вже наявних лічильників.
+ *
+ * На відміну від naive_search не очищає результат, тому кілька текстів
+ * (або кілька потоків, кожен зі своїм блоком ThreadCounters) можуть
+ * накопичувати кількості в один масив.
+ *
+ * @param text Вхідний текст.
+ * @param patterns Набір шаблонів.
+ * @param counts Масив щонайменше з patterns.size() лічильників.
+ * @param options Семантика збігу.
+ * @return Кількість входжень, знайдених у цьому тексті.
+ */
+size_t naive_accumulate(const std::string &text,
+                        const std::vector<std::string> &patterns,
+                        size_t *counts,
+                        const MatchOptions &options = MatchOptions());
+
+/**
+ * @brief Переводить текст у нижній регістр згідно з режимом.
+ *
+ * Для CaseMode::UnicodeFold згортаються латинські (ASCII, Latin-1, Latin
+ * Extended-A) та кириличні (U+0400..U+052F) символи UTF-8; некоректні
+ * послідовності та інші символи копіюються без змін. Довжина тексту
+ * не змінюється, тож позиції байтів зберігаються.
+ *
+ * @param text Вхідний текст.
+ * @param mode Режим врахування регістру.
+ * @return Текст після згортки регістру.
+ */
+std::string fold_case(const std::string &text, CaseMode mode);
+
+/**
+ * @brief Зводить шаблон до вигляду, у якому його шукають рушії.
+ *
+ * Для Scope::WithinWord і Scope::WholeWord з шаблону видаляються не-літери, а за згортки
+ * регістру шаблон переводиться в нижній регістр (див. fold_case). Шаблон,
+ * що після цього став порожнім, не має жодного входження.
+ *
+ * @param pattern Вихідний шаблон.
+ * @param options Семантика збігу.
+ * @return Нормалізований шаблон.
+ */
+std::string normalize_pattern(const std::string &pattern, const MatchOptions &options);
+
+/**
+ * @brief Один збіг шаблону в тексті.
+ */
+struct Match {
+    size_t pos;  ///< Позиція першого символу збігу в тексті.
+    size_t len;  ///< Довжина збігу в байтах тексту.
+    int pattern; ///< Індекс шаблону.
+};
+
+/**
+ * @brief Які збіги повідомляються, коли вони перекриваються.
+ */
+enum class MatchKind {
+    Overlapping,    ///< Усі збіги, зокрема ті, що перекриваються.
+    NonOverlapping, ///< Збіг, що закінчується найраніше (з них — найдовший); далі пошук після нього.
+    LeftmostFirst,  ///< Збіг, що починається найлівіше (з них — шаблон із меншим індексом).
+    LeftmostLongest ///< Збіг, що починається найлівіше (з них — найдовший, далі — менший індекс).
+};
+
+/**
+ * @brief Обробник одного збігу в режимі find_matches.
+ */
+typedef std::function<void(const Match &match)> MatchCallback;
+
+/**
+ * @brief Обробник результату одного запису (рядка) у режимі search_records.
+ *
+ * Отримує номер запису (від 0), межі запису в тексті [begin, end) без
+ * символу '\n' та збіги, знайдені в ньому. Результат hits дійсний лише
+ * під час виклику.
+ */
+typedef std::function<void(size_t record, size_t begin, size_t end,
+                           const SparseCounts &hits)> RecordCallback;
 
 /**
  * @brief Вершина автомата Ахо–Корасіка.
  *
- * Містить масив переходів для символів англійського алфавіту,
- * суфіксне посилання та список індексів шаблонів, які закінчуються
- * в цій вершині.
+ * Містить суфіксне посилання та список індексів шаблонів, які закінчуються
+ * в цій вершині. Переходи всіх вершин зберігаються в AhoCorasick::next.
  */
 struct AhoNode {
-    static const int ALPHA = 26; ///< Розмір алфавіту (літери a..z).
-    int next[ALPHA];            ///< Переходи за символами.
     int link;                   ///< Суфіксне (failure) посилання.
     std::vector<int> out;       ///< Індекси шаблонів, що закінчуються тут.
 
     /**
-     * @brief Створює вершину з початковими значеннями для переходів та посилання.
+     * @brief Створює вершину з початковим значенням суфіксного посилання.
      */
     AhoNode();
 };
 
+/**
+ * @brief Звіт про розмір і форму автомата Ахо–Корасіка.
+ *
+ * Розміри в байтах враховують зарезервовану (capacity), а не лише
+ * використану пам'ять. «Гаряча» пам'ять — це те, що читає цикл пошуку:
+ * вершини, таблиця переходів і списки виходів; за нею оцінюється, у який рівень кешу
+ * автомат поміщається цілком.
+ */
+struct AhoStats {
+    size_t states;         ///< Кількість вершин.
+    size_t edges;          ///< Кількість ребер бору (без доповнених переходів).
+    size_t outputs;        ///< Сумарна довжина списків виходів.
+    size_t node_bytes;     ///< Пам'ять масиву вершин.
+    size_t transition_bytes; ///< Пам'ять таблиці переходів і класів байтів.
+    size_t output_bytes;   ///< Пам'ять списків виходів.
+    size_t pattern_bytes;  ///< Пам'ять копії шаблонів.
+    size_t aux_bytes;      ///< Інші службові масиви (довжини шаблонів).
+    size_t total_bytes;    ///< Уся пам'ять автомата, включно з самим об'єктом.
+    size_t hot_bytes;      ///< Пам'ять, яку читає цикл пошуку.
+    std::vector<size_t> depth_histogram;  ///< [d] — кількість вершин на глибині d.
+    std::vector<size_t> fanout_histogram; ///< [k] — кількість вершин із k дітьми в бору.
+    std::vector<size_t> output_histogram; ///< [k] — кількість вершин із k виходами.
+    size_t l1_bytes;       ///< Розмір кешу даних L1 (0, якщо невідомо).
+    size_t l2_bytes;       ///< Розмір кешу L2 (0, якщо невідомо).
+    size_t llc_bytes;      ///< Розмір кешу останнього рівня (0, якщо невідомо).
+    std::string residency; ///< Найменший рівень, у який вміщується hot_bytes: "L1", "L2", "LLC", "DRAM"
+                           ///< або "unknown", якщо розміри кешів визначити не вдалося.
+};
+
+/**
+ * @brief Друкує звіт про автомат у зручному для читання вигляді.
+ *
+ * Гістограми друкуються лише непорожніми кошиками у форматі значення:кількість.
+ *
+ * @param os Потік виводу.
+ * @param stats Звіт.
+ * @param indent Відступ на початку кожного рядка.
+ */
+void print_stats(std::ostream &os, const AhoStats &stats, const char *indent);
+
 /**
  * @brief Реалізація алгоритму Ахо–Корасіка для пошуку множини шаблонів.
  *
  * Клас будує автомат за набором рядків (patterns) і дозволяє
  * виконувати пошук усіх входжень цих шаблонів у тексті за один прохід.
+ *
+ * Алфавіт автомата — класи байтів: кожен байт, що зустрічається в
+ * нормалізованих шаблонах, має власний клас (для CaseMode::AsciiFold великі
+ * й малі літери ділять один клас), а всі інші байти потрапляють у клас 0,
+ * перехід за яким з будь-якої вершини веде в корінь. Тому цикл пошуку не
+ * має розгалужень на символ: один перегляд таблиці класів і один — таблиці
+ * переходів.
+ *
+ * Для CaseMode::UnicodeFold бор будується за шаблонами в нижньому регістрі,
+ * а для кожного двобайтового символу UTF-8 у бор додаються паралельні шляхи
+ * байтів його великої форми, що ведуть у ту саму вершину. Згортка регістру
+ * таким чином вбудована в переходи, і цикл пошуку не декодує UTF-8.
+ * Шаблони в цьому режимі мають складатися з цілих символів UTF-8; текст
+ * може бути довільним.
  */
 struct AhoCorasick {
     std::vector<AhoNode> trie;        ///< Масив вершин бору/автомата.
     std::vector<std::string> patterns;///< Збережені шаблони.
+    std::vector<int> pattern_len;     ///< Довжина кожного шаблону в байтах тексту (після нормалізації).
+    MatchOptions options;             ///< Семантика збігу, з якою побудовано автомат.
+    unsigned short byte_class[256];   ///< Клас кожного байта (0 — байт не зустрічається в шаблонах).
+    int alpha;                        ///< Кількість класів байтів, включно з класом 0.
+    std::vector<int> next;            ///< Переходи: next[v * alpha + клас].
+    int max_len;                      ///< Найбільша з pattern_len.
 
     /**
      * @brief Створює автомат із початковою кореневою вершиною.
@@ -53,14 +292,18 @@ struct AhoCorasick {
     AhoCorasick();
 
     /**
-     * @brief Перетворює символ у індекс від 0 до 25.
+     * @brief Повертає клас байта в алфавіті автомата.
      * @param c Вхідний символ.
-     * @return Індекс символу в алфавіті або -1, якщо символ не літера.
+     * @return Клас від 1 до alpha - 1 або 0, якщо байт не зустрічається в шаблонах.
      */
-    static int char_id(char c);
+    int char_id(char c) const;
 
     /**
      * @brief Додає один шаблон до бору.
+     *
+     * Шаблон нормалізується згідно з options; усі його байти мають уже
+     * мати класи (їх призначає build_automaton).
+     *
      * @param s Рядок-шаблон.
      * @param idx Індекс шаблону у векторі patterns.
      */
@@ -68,9 +311,15 @@ struct AhoCorasick {
 
     /**
      * @brief Будує автомат Ахо–Корасіка за заданим набором шаблонів.
+     *
+     * Попередній вміст автомата відкидається.
+     *
      * @param patterns_ Набір шаблонів, які необхідно шукати.
+     * @param options_ Семантика збігу (за замовчуванням — без урахування
+     *                 регістру, лише всередині слів).
      */
-    void build_automaton(const std::vector<std::string> &patterns_);
+    void build_automaton(const std::vector<std::string> &patterns_,
+                         const MatchOptions &options_ = {CaseMode::AsciiFold, Scope::WithinWord});
 
     /**
      * @brief Виконує пошук усіх шаблонів у тексті.
@@ -80,4 +329,684 @@ struct AhoCorasick {
      * @return Загальна кількість входжень усіх шаблонів.
      */
     size_t search(const std::string &text, std::vector<size_t> &per_pattern) const;
+
+    /**
+     * @brief Виконує пошук із розрідженим результатом.
+     *
+     * Очищає лише лічильники, зачеплені попереднім пошуком, тому підходить
+     * для багаторазового пошуку в коротких рядках за великим словником.
+     *
+     * @param text Текст для пошуку.
+     * @param result Розріджений результат; попередній вміст скидається через reset().
+     * @return Загальна кількість входжень усіх шаблонів.
+     */
+    size_t search(const std::string &text, SparseCounts &result) const;
+
+    /**
+     * @brief Виконує пошук у тексті, розбитому на записи символом '\n'.
+     *
+     * Текст проходиться один раз: межі записів знаходяться через memchr
+     * (векторизований у стандартній бібліотеці), а для кожного запису
+     * викликається on_record з його збігами. Викликається для кожного
+     * запису, зокрема порожнього; після завершального '\n' новий запис
+     * не починається.
+     *
+     * @param text Текст із записами.
+     * @param on_record Обробник результату кожного запису.
+     * @return Загальна кількість входжень у всіх записах.
+     */
+    size_t search_records(const std::string &text, const RecordCallback &on_record) const;
+
+    /**
+     * @brief Перевіряє, чи є в тексті хоча б один збіг.
+     *
+     * Сканування зупиняється на першому знайденому збігу.
+     *
+     * @param text Текст для пошуку.
+     * @return true, якщо хоча б один шаблон зустрічається в тексті.
+     */
+    bool contains_any(const std::string &text) const;
+
+    /**
+     * @brief Знаходить перший збіг у тексті.
+     *
+     * Першим вважається збіг, що закінчується найраніше; якщо таких кілька,
+     * обирається найдовший. Сканування зупиняється одразу після нього.
+     *
+     * @param text Текст для пошуку.
+     * @param match Сюди записується знайдений збіг.
+     * @return true, якщо збіг знайдено.
+     */
+    bool first_match(const std::string &text, Match &match) const;
+
+    /**
+     * @brief Повідомляє збіги згідно з обраною політикою перекриття.
+     *
+     * Збіги передаються обробнику в порядку зростання позиції. Для
+     * MatchKind::Overlapping і NonOverlapping сканування однопрохідне. Для
+     * лівобічних режимів утримується лише один кандидат: він остаточний,
+     * коли поточна позиція відійшла від його початку далі, ніж на max_len.
+     * Якщо при цьому було відкинуто збіг, що починається після кандидата,
+     * сканування відновлюється з кінця кандидата, тож кожен байт
+     * переглядається повторно щонайбільше на відстані max_len.
+     *
+     * @param text Текст для пошуку.
+     * @param kind Політика перекриття.
+     * @param on_match Обробник кожного збігу.
+     * @return Кількість повідомлених збігів.
+     */
+    size_t find_matches(const std::string &text, MatchKind kind, const MatchCallback &on_match) const;
+
+    /**
+     * @brief Перевіряє, чи кожен шаблон зустрічається щонайменше k разів.
+     *
+     * Досягнуті шаблони позначаються в компактному бітсеті, і сканування
+     * зупиняється, щойно всі шаблони досягли порогу. Порожні шаблони
+     * ніколи не зустрічаються, тож за k > 0 відповідь для них — false.
+     *
+     * @param text Текст для пошуку.
+     * @param k Поріг кількості входжень.
+     * @return true, якщо всі шаблони мають щонайменше k входжень.
+     */
+    bool all_reach(const std::string &text, size_t k) const;
+
+    /**
+     * @brief Збирає статистику розміру та форми автомата.
+     *
+     * Глибина вершини визначається обходом у ширину від кореня, а ребром
+     * бору вважається перехід, що веде на глибину рівно на 1 більшу
+     * (доповнені переходи автомата ніколи не збільшують глибину).
+     *
+     * @return Звіт про автомат.
+     */
+    AhoStats stats() const;
+
+    /**
+     * @brief Виконує пошук і додає збіги до вже наявних лічильників.
+     *
+     * Лічильники не очищаються, тому кожен обробник може накопичувати
+     * результати кількох текстів у власному блоці ThreadCounters.
+     *
+     * @param text Текст для пошуку.
+     * @param counts Масив щонайменше з patterns.size() лічильників.
+     * @return Кількість входжень, знайдених у цьому тексті.
+     */
+    size_t accumulate(const std::string &text, size_t *counts) const;
+};
+
+/**
+ * @brief Набір лічильників збігів для паралельних обробників.
+ *
+ * Кожен обробник отримує власний блок лічильників, вирівняний і доповнений
+ * до розміру кеш-лінії, тому потоки не ділять між собою жодної лінії
+ * (немає false sharing) і не потребують блокувань під час пошуку.
+ * Останній елемент блоку зберігає загальну кількість збігів обробника.
+ * Після завершення роботи блоки зливаються деревоподібною редукцією.
+ */
+struct ThreadCounters {
+    static const size_t CACHE_LINE = 64; ///< Розмір кеш-лінії в байтах.
+
+    size_t n_workers;            ///< Кількість обробників (блоків).
+    size_t n_patterns;           ///< Кількість шаблонів у кожному блоці.
+    size_t stride;               ///< Відстань між блоками (у лічильниках).
+    size_t offset;               ///< Зсув першого вирівняного блоку в storage.
+    std::vector<size_t> storage; ///< Пам'ять під усі блоки.
+
+    /**
+     * @brief Створює обнулені блоки для заданої кількості обробників.
+     * @param workers Кількість обробників.
+     * @param patterns Кількість шаблонів.
+     */
+    ThreadCounters(size_t workers, size_t patterns);
+
+    /**
+     * @brief Повертає блок лічильників обробника.
+     * @param worker Номер обробника від 0 до n_workers - 1.
+     * @return Вказівник на n_patterns лічильників, вирівняний за кеш-лінією.
+     */
+    size_t *block(size_t worker);
+
+    /**
+     * @brief Повертає загальну кількість збігів обробника.
+     * @param worker Номер обробника.
+     * @return Посилання на лічильник усередині блоку обробника.
+     */
+    size_t &total(size_t worker);
+
+    /**
+     * @brief Зливає блоки всіх обробників у підсумковий результат.
+     *
+     * Блоки додаються попарно (1 до 0, 3 до 2, потім 2 до 0 і т.д.), тому
+     * глибина редукції — log2(n_workers). Стовпці лічильників діляться між
+     * threads потоками кратно кеш-лінії, тож злиття також не має false sharing.
+     * Після виклику блок 0 містить суму, інші блоки залишаються проміжними.
+     *
+     * @param per_pattern Вектор, у який записується кількість входжень кожного шаблону.
+     * @param threads Кількість потоків для злиття.
+     * @return Загальна кількість входжень усіх шаблонів.
+     */
+    size_t merge(std::vector<size_t> &per_pattern, unsigned threads = 1);
+};
+
+/**
+ * @brief Паралельний пошук автоматом Ахо–Корасіка в одному тексті.
+ *
+ * Текст ділиться на workers частин. Кожен потік починає сканування трохи
+ * раніше своєї частини (на довжину найдовшого шаблону), щоб не пропустити
+ * збіги на межі, але рахує лише збіги, які закінчуються в його частині.
+ * Результати накопичуються в ThreadCounters і зливаються наприкінці.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param per_pattern Вектор, у який записується кількість входжень кожного шаблону.
+ * @param workers Кількість потоків.
+ * @return Загальна кількість входжень усіх шаблонів.
+ */
+size_t parallel_search(const AhoCorasick &aho,
+                       const std::string &text,
+                       std::vector<size_t> &per_pattern,
+                       unsigned workers);
+
+/**
+ * @brief Розріджена матриця «документ × шаблон» у форматі CSR.
+ *
+ * Рядок d займає [row_offset[d], row_offset[d + 1]) у columns і values;
+ * індекси шаблонів у рядку зростають.
+ */
+struct CountMatrix {
+    size_t cols;                   ///< Кількість стовпців (шаблонів).
+    std::vector<size_t> row_offset; ///< Початок кожного рядка; row_offset.back() — кількість ненульових.
+    std::vector<int> columns;      ///< Індекс шаблону кожного ненульового елемента.
+    std::vector<size_t> values;    ///< Кількість входжень кожного ненульового елемента.
+
+    /**
+     * @brief Повертає кількість рядків (документів).
+     * @return Кількість рядків.
+     */
+    size_t rows() const;
+};
+
+/**
+ * @brief Пошук у багатьох документах із результатом у вигляді матриці CSR.
+ *
+ * Документи діляться між потоками суцільними діапазонами з приблизно
+ * однаковою кількістю байтів. Кожен потік перевикористовує один
+ * SparseCounts і дописує ненульові лічильники документа до власних
+ * масивів; щільні вектори на документ не створюються. Наприкінці зсуви
+ * рядків обчислюються префіксною сумою, а потоки паралельно копіюють
+ * свої частини на місце.
+ *
+ * @param aho Побудований автомат.
+ * @param documents Документи.
+ * @param matrix Результат; попередній вміст замінюється.
+ * @param workers Кількість потоків.
+ * @return Загальна кількість входжень у всіх документах.
+ */
+size_t batch_search(const AhoCorasick &aho,
+                    const std::vector<std::string> &documents,
+                    CountMatrix &matrix,
+                    unsigned workers);
+
+/**
+ * @brief Відстежуваний шаблон у зведенні TopKSummary.
+ *
+ * Справжня кількість входжень лежить у [count - error, count].
+ */
+struct TopKEntry {
+    int pattern;  ///< Індекс шаблону.
+    size_t count; ///< Оцінка зверху кількості входжень.
+    size_t error; ///< Найбільша можлива переоцінка.
+};
+
+/**
+ * @brief Зведення найчастіших шаблонів потоку в обмеженій пам'яті (Space-Saving).
+ *
+ * Відстежується не більше capacity шаблонів у мінімальній купі за count.
+ * Новий шаблон, коли місця немає, витісняє найрідший і успадковує його
+ * кількість як похибку. Будь-який шаблон із кількістю понад total / capacity
+ * гарантовано відстежується. Пам'ять не залежить від розміру словника.
+ * Зведення кількох шардів об'єднуються через merge() з тими самими
+ * гарантіями.
+ */
+struct TopKSummary {
+    size_t capacity;                     ///< Найбільша кількість відстежуваних шаблонів.
+    size_t total;                        ///< Загальна кількість врахованих входжень.
+    std::vector<TopKEntry> heap;         ///< Мінімальна купа за count.
+    std::unordered_map<int, size_t> slot; ///< Позиція шаблону в heap.
+
+    /**
+     * @brief Створює порожнє зведення.
+     * @param capacity_ Найбільша кількість відстежуваних шаблонів.
+     */
+    explicit TopKSummary(size_t capacity_ = 64);
+
+    /**
+     * @brief Очищає зведення.
+     * @param capacity_ Нова найбільша кількість відстежуваних шаблонів.
+     */
+    void reset(size_t capacity_);
+
+    /**
+     * @brief Враховує входження шаблону.
+     * @param pattern Індекс шаблону.
+     * @param weight Кількість входжень.
+     */
+    void add(int pattern, size_t weight = 1);
+
+    /**
+     * @brief Додає зведення іншого шарду.
+     *
+     * Шаблон, якого немає в одному зі зведень, отримує з нього найменшу
+     * кількість (якщо те заповнене), що зберігає межі [count - error, count].
+     *
+     * @param other Зведення іншого шарду.
+     */
+    void merge(const TopKSummary &other);
+
+    /**
+     * @brief Найменша кількість, яку може мати невідстежуваний шаблон.
+     * @return Найменший count, якщо зведення заповнене, інакше 0.
+     */
+    size_t floor() const;
+
+    /**
+     * @brief Повертає k найчастіших шаблонів.
+     * @param k Кількість шаблонів.
+     * @return Записи за спаданням count (за рівності — за зростанням індексу).
+     */
+    std::vector<TopKEntry> top(size_t k) const;
+};
+
+/**
+ * @brief Додає входження шаблонів у тексті до зведення найчастіших.
+ *
+ * Зведення оновлюється під час сканування, без щільного масиву
+ * лічильників. Зведення не очищається, тож послідовні фрагменти потоку
+ * накопичуються.
+ *
+ * @param aho Побудований автомат.
+ * @param text Фрагмент тексту.
+ * @param summary Зведення.
+ * @return Кількість входжень у фрагменті.
+ */
+size_t accumulate_top(const AhoCorasick &aho, const std::string &text, TopKSummary &summary);
+
+/**
+ * @brief Наближені лічильники шаблонів у фіксованій пам'яті (Count-Min Sketch).
+ *
+ * depth рядків по width лічильників; шаблон збільшує по одному лічильнику
+ * в кожному рядку (позиції задають незалежні хеші індексу), а оцінка —
+ * мінімум із них. Оцінка ніколи не менша за справжню кількість і з
+ * імовірністю щонайменше 1 - delta перевищує її не більше ніж на
+ * epsilon * total. Пам'ять — width * depth лічильників незалежно від
+ * розміру словника. Ескізи з однаковими розмірами додаються поелементно,
+ * тож кожен потік чи шард веде власний і зливає їх наприкінці.
+ */
+struct CountMinSketch {
+    size_t width;              ///< Лічильників у рядку (степінь двійки).
+    size_t depth;              ///< Кількість рядків.
+    size_t total;              ///< Загальна кількість врахованих входжень.
+    std::vector<size_t> cells; ///< Лічильники, рядок за рядком.
+
+    /**
+     * @brief Створює порожній ескіз за бажаними межами похибки.
+     *
+     * width = e / epsilon, округлене вгору до степеня двійки;
+     * depth = ln(1 / delta), округлене вгору.
+     *
+     * @param epsilon Допустима відносна похибка (частка від total).
+     * @param delta Імовірність перевищити похибку.
+     */
+    explicit CountMinSketch(double epsilon = 0.001, double delta = 0.01);
+
+    /**
+     * @brief Обнуляє всі лічильники.
+     */
+    void clear();
+
+    /**
+     * @brief Враховує входження шаблону.
+     * @param pattern Індекс шаблону.
+     * @param weight Кількість входжень.
+     */
+    void add(int pattern, size_t weight = 1);
+
+    /**
+     * @brief Повертає оцінку кількості входжень шаблону.
+     * @param pattern Індекс шаблону.
+     * @return Оцінка зверху.
+     */
+    size_t estimate(int pattern) const;
+
+    /**
+     * @brief Гарантована (з імовірністю 1 - delta) межа переоцінки.
+     * @return Найбільша переоцінка для поточного total.
+     */
+    size_t error_bound() const;
+
+    /**
+     * @brief Додає інший ескіз.
+     * @param other Ескіз тих самих розмірів.
+     * @return false, якщо розміри ескізів різні (тоді нічого не змінюється).
+     */
+    bool merge(const CountMinSketch &other);
+};
+
+/**
+ * @brief Додає входження шаблонів у тексті до ескізу Count-Min.
+ *
+ * Кожен збіг одразу оновлює ескіз; щільний масив лічильників на весь
+ * словник не створюється. Ескіз не очищається.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param sketch Ескіз.
+ * @return Кількість входжень у тексті.
+ */
+size_t accumulate_sketch(const AhoCorasick &aho, const std::string &text, CountMinSketch &sketch);
+
+/**
+ * @brief Іменований словник шаблонів.
+ */
+struct Dictionary {
+    std::string name;                  ///< Назва словника.
+    std::vector<std::string> patterns; ///< Шаблони словника.
+};
+
+/**
+ * @brief Походження шаблону в об'єднаному автоматі.
+ */
+struct PatternTag {
+    int dictionary; ///< Індекс словника.
+    int pattern;    ///< Індекс шаблону всередині словника.
+};
+
+/**
+ * @brief Результат пошуку за кількома словниками: один блок на словник.
+ *
+ * Лічильники всіх словників лежать в одному масиві поспіль; блок словника d
+ * займає [offset[d], offset[d + 1]).
+ */
+struct DictionaryCounts {
+    std::vector<size_t> counts; ///< Лічильники всіх шаблонів усіх словників.
+    std::vector<size_t> offset; ///< Початок блоку кожного словника; offset.back() — кількість шаблонів.
+    std::vector<size_t> totals; ///< Загальна кількість входжень для кожного словника.
+
+    /**
+     * @brief Повертає блок лічильників словника.
+     * @param dictionary Індекс словника.
+     * @return Вказівник на лічильник першого шаблону словника.
+     */
+    const size_t *block(size_t dictionary) const;
+
+    /**
+     * @brief Повертає кількість шаблонів у словнику.
+     * @param dictionary Індекс словника.
+     * @return Розмір блоку.
+     */
+    size_t block_size(size_t dictionary) const;
+};
+
+/**
+ * @brief Об'єднаний автомат для кількох незалежних словників.
+ *
+ * Шаблони всіх словників потрапляють в один AhoCorasick під глобальними
+ * індексами, а tags відновлює для кожного пару (словник, шаблон). Тому
+ * текст сканується один раз замість одного проходу на словник, а
+ * результати збігаються з пошуком окремими автоматами. Однакові шаблони
+ * з різних словників рахуються в кожному з них. Семантика збігу спільна
+ * для всіх словників.
+ */
+struct MultiDictionary {
+    AhoCorasick aho;                ///< Автомат за шаблонами всіх словників.
+    std::vector<std::string> names; ///< Назви словників.
+    std::vector<size_t> offset;     ///< Глобальний індекс першого шаблону кожного словника.
+    std::vector<PatternTag> tags;   ///< Походження кожного глобального шаблону.
+
+    /**
+     * @brief Будує об'єднаний автомат.
+     *
+     * @param dictionaries Словники.
+     * @param options Семантика збігу.
+     */
+    void build(const std::vector<Dictionary> &dictionaries,
+               const MatchOptions &options = {CaseMode::AsciiFold, Scope::WithinWord});
+
+    /**
+     * @brief Повертає індекс словника за назвою.
+     * @param name Назва словника.
+     * @return Індекс або -1, якщо словника немає.
+     */
+    int find(const std::string &name) const;
+
+    /**
+     * @brief Повертає походження глобального індексу шаблону (наприклад, з Match).
+     * @param pattern Глобальний індекс шаблону.
+     * @return Пара (словник, шаблон у словнику).
+     */
+    PatternTag tag(int pattern) const;
+
+    /**
+     * @brief Шукає шаблони всіх словників за один прохід.
+     *
+     * @param text Текст для пошуку.
+     * @param result Лічильники по блоках словників; попередній вміст замінюється.
+     * @return Загальна кількість входжень у всіх словниках.
+     */
+    size_t search(const std::string &text, DictionaryCounts &result) const;
+};
+
+/**
+ * @brief Приймач вихідного потоку байтів для replace_all.
+ *
+ * Отримує послідовні фрагменти результату; вказівник дійсний лише під час
+ * виклику.
+ */
+typedef std::function<void(const char *data, size_t size)> WriteSink;
+
+/**
+ * @brief Замінює входження шаблонів за один прохід.
+ *
+ * Збіги обираються за правилом MatchKind::LeftmostLongest. Текст між
+ * збігами та рядки-заміни передаються в sink напряму, без проміжних
+ * копій, тож результат можна писати одразу у файл чи сокет. Якщо для
+ * шаблону немає заміни (індекс поза replacements), збіг лишається як є.
+ *
+ * @param aho Побудований автомат.
+ * @param text Вхідний текст.
+ * @param replacements Заміна для кожного шаблону за його індексом.
+ * @param sink Приймач результату.
+ * @return Кількість виконаних замін.
+ */
+size_t replace_all(const AhoCorasick &aho,
+                   const std::string &text,
+                   const std::vector<std::string> &replacements,
+                   const WriteSink &sink);
+
+/**
+ * @brief Рахує символи '\n' у блоці байтів.
+ *
+ * Байти обробляються словами по 8 (SWAR): нульові після XOR з '\n' байти
+ * позначаються старшим бітом без переносів між байтами, а позначки
+ * накопичуються в окремих байтах слова. Це у 2–3 рази швидше за
+ * побайтовий цикл або memchr на кожен рядок, коли рядки короткі.
+ *
+ * @param data Байти.
+ * @param size Кількість байтів.
+ * @return Кількість символів '\n'.
+ */
+size_t count_newlines(const char *data, size_t size);
+
+/**
+ * @brief Номер рядка й стовпця позиції в тексті.
+ */
+struct LineColumn {
+    size_t line;   ///< Номер рядка (від 1).
+    size_t column; ///< Номер стовпця в байтах від початку рядка (від 1).
+};
+
+/**
+ * @brief Перетворює позиції в тексті на рядок і стовпець.
+ *
+ * Пам'ятає останню позицію та її рядок, тож для зростаючих позицій
+ * (як у find_matches) кожен байт тексту переглядається щонайбільше двічі
+ * за весь прохід, а символи '\n' між позиціями рахуються блоками через
+ * count_newlines. Позиція, менша за попередню, теж обробляється, але
+ * повільніше.
+ */
+struct LineCursor {
+    const char *text;  ///< Початок тексту.
+    size_t size;       ///< Довжина тексту.
+    size_t pos;        ///< Остання запитана позиція.
+    size_t line;       ///< Її рядок (від 1).
+    size_t line_start; ///< Позиція початку цього рядка.
+
+    /**
+     * @brief Створює курсор на початку тексту.
+     * @param text_ Текст; має жити довше за курсор.
+     */
+    explicit LineCursor(const std::string &text_);
+
+    /**
+     * @brief Повертає рядок і стовпець позиції.
+     * @param offset Позиція в тексті (не більша за його довжину).
+     * @return Рядок і стовпець.
+     */
+    LineColumn locate(size_t offset);
+};
+
+/**
+ * @brief Обробник збігу разом із рядком і стовпцем його початку.
+ */
+typedef std::function<void(const Match &match, const LineColumn &at)> LocatedMatchCallback;
+
+/**
+ * @brief Повідомляє збіги згідно з політикою перекриття разом із їхнім рядком і стовпцем.
+ *
+ * Збіги від find_matches надходять у порядку зростання позиції (для
+ * MatchKind::Overlapping початок наступного збігу може бути лише трохи
+ * лівіше), тож один LineCursor обчислює рядки для всіх за один прохід.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param kind Політика перекриття.
+ * @param on_match Обробник кожного збігу.
+ * @return Кількість повідомлених збігів.
+ */
+size_t find_located(const AhoCorasick &aho,
+                    const std::string &text,
+                    MatchKind kind,
+                    const LocatedMatchCallback &on_match);
+
+/**
+ * @brief Межі, яких не перетинає контекст фрагмента.
+ */
+enum class SnippetClamp {
+    Bytes, ///< Лише межі символів UTF-8.
+    Line   ///< Межі символів UTF-8 і рядка збігу (без '\n' та '\r' перед ним).
+};
+
+/**
+ * @brief Фрагмент тексту навколо одного або кількох збігів.
+ */
+struct Snippet {
+    std::string_view text; ///< Фрагмент; вказує в буфер вихідного тексту.
+    size_t offset;         ///< Позиція фрагмента в тексті.
+    LineColumn at;         ///< Рядок і стовпець початку фрагмента.
+};
+
+/**
+ * @brief Обробник фрагмента; matches — збіги, що в нього потрапили.
+ *
+ * Вектор matches перевикористовується між викликами й дійсний лише під час виклику.
+ */
+typedef std::function<void(const Snippet &snippet, const std::vector<Match> &matches)> SnippetCallback;
+
+/**
+ * @brief Повертає збіг із контекстом до context байтів з кожного боку.
+ *
+ * Контекст обрізається до меж тексту, не розриває символів UTF-8 (межа
+ * зсувається до збігу, доки не потрапить на початок символу), а за
+ * SnippetClamp::Line не виходить за рядок збігу. Сам збіг входить завжди.
+ * Нічого не копіюється, тож текст може бути, наприклад, відображеним файлом.
+ *
+ * @param text Текст.
+ * @param pos Позиція збігу.
+ * @param len Довжина збігу.
+ * @param context Найбільша кількість байтів контексту з кожного боку.
+ * @param clamp Межі контексту.
+ * @return Фрагмент у буфері text.
+ */
+std::string_view snippet_around(std::string_view text, size_t pos, size_t len, size_t context, SnippetClamp clamp);
+
+/**
+ * @brief Повідомляє збіги, згруповані у фрагменти з контекстом.
+ *
+ * Фрагменти збігів, що перекриваються або стикаються, об'єднуються в
+ * один, тож кожен байт тексту потрапляє щонайбільше в один фрагмент
+ * (для MatchKind::Overlapping довгий збіг, що закінчується пізніше, може
+ * зачепити вже повідомлений фрагмент).
+ * Фрагменти — string_view у буфер text, без копіювання й виділення пам'яті
+ * на кожен збіг.
+ *
+ * @param aho Побудований автомат.
+ * @param text Текст для пошуку.
+ * @param kind Політика перекриття.
+ * @param context Найбільша кількість байтів контексту з кожного боку збігу.
+ * @param clamp Межі контексту.
+ * @param on_snippet Обробник кожного фрагмента.
+ * @return Кількість фрагментів.
+ */
+size_t find_snippets(const AhoCorasick &aho,
+                     const std::string &text,
+                     MatchKind kind,
+                     size_t context,
+                     SnippetClamp clamp,
+                     const SnippetCallback &on_snippet);
+
+/**
+ * @brief Пошук у потоці, що надходить фрагментами.
+ *
+ * Між викликами feed() зберігається вершина автомата (а для
+ * Scope::WholeWord — довжина поточного слова), тож збіги через межу
+ * фрагментів знаходяться так само, як у суцільному тексті. Для
+ * Scope::WholeWord слово в кінці фрагмента перевіряється лише тоді, коли
+ * стане відомо, що воно закінчилося: у наступному фрагменті або в finish().
+ */
+struct StreamScanner {
+    const AhoCorasick *aho; ///< Автомат.
+    int state;              ///< Поточна вершина.
+    size_t word_len;        ///< Довжина незавершеного слова (Scope::WholeWord).
+    size_t consumed;        ///< Кількість байтів, переданих у feed().
+
+    /**
+     * @brief Створює сканер на початку потоку.
+     * @param aho_ Побудований автомат; має жити довше за сканер.
+     */
+    explicit StreamScanner(const AhoCorasick &aho_);
+
+    /**
+     * @brief Повертає сканер на початок потоку.
+     */
+    void reset();
+
+    /**
+     * @brief Сканує наступний фрагмент потоку.
+     *
+     * Збіги додаються до hits без очищення (масив counts розширюється
+     * за потреби), тож один результат може накопичувати кілька фрагментів.
+     *
+     * @param data Байти фрагмента.
+     * @param size Кількість байтів.
+     * @param hits Розріджений результат, до якого додаються збіги.
+     * @return Кількість входжень, знайдених під час цього виклику.
+     */
+    size_t feed(const char *data, size_t size, SparseCounts &hits);
+
+    /**
+     * @brief Завершує потік: перевіряє останнє слово й повертає сканер на початок.
+     * @param hits Розріджений результат, до якого додаються збіги.
+     * @return Кількість входжень, знайдених під час цього виклику.
+     */
+    size_t finish(SparseCounts &hits);
 };
@@ -0,0 +1,307 @@
+#include "shared_automaton.hpp"
+#include "scan_loop.hpp"
+#include <atomic>
+#include <cstring>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/**
+ * @brief Округлює зміщення вгору до кеш-лінії.
+ * @param offset Зміщення.
+ * @return Вирівняне зміщення.
+ */
+static uint64_t align64(uint64_t offset) {
+    return (offset + 63) / 64 * 64;
+}
+
+/**
+ * @brief Розкладає масиви образу та заповнює зміщення в заголовку.
+ * @param aho Побудований автомат.
+ * @param h Заголовок, що заповнюється.
+ */
+static void layout(const AhoCorasick &aho, FlatHeader &h) {
+    size_t outputs = 0;
+    for (const AhoNode &node : aho.trie) outputs += node.out.size();
+
+    memset(&h, 0, sizeof(h));
+    h.magic = FLAT_MAGIC;
+    h.version = FLAT_VERSION;
+    h.states = (int32_t)aho.trie.size();
+    h.alpha = aho.alpha;
+    h.patterns = (int32_t)aho.pattern_len.size();
+    h.max_len = aho.max_len;
+    h.case_mode = (int32_t)aho.options.case_mode;
+    h.scope = (int32_t)aho.options.scope;
+
+    h.class_offset = align64(sizeof(FlatHeader));
+    h.next_offset = align64(h.class_offset + 256 * sizeof(uint16_t));
+    h.out_begin_offset = align64(h.next_offset + (uint64_t)h.states * h.alpha * sizeof(int32_t));
+    h.out_offset = align64(h.out_begin_offset + ((uint64_t)h.states + 1) * sizeof(uint32_t));
+    h.len_offset = align64(h.out_offset + outputs * sizeof(int32_t));
+    h.total_bytes = align64(h.len_offset + (uint64_t)h.patterns * sizeof(int32_t));
+}
+
+/**
+ * @brief Розмір образу автомата.
+ * @param aho Побудований автомат.
+ * @return Розмір у байтах.
+ */
+size_t flat_size(const AhoCorasick &aho) {
+    FlatHeader h;
+    layout(aho, h);
+    return h.total_bytes;
+}
+
+/**
+ * @brief Записує образ автомата.
+ *
+ * Вихідні списки вершин записуються поспіль у форматі CSR, у тому самому
+ * порядку, що й у AhoNode::out.
+ *
+ * @param aho Побудований автомат.
+ * @param dst Буфер розміром щонайменше flat_size(aho).
+ */
+void write_flat(const AhoCorasick &aho, void *dst) {
+    FlatHeader h;
+    layout(aho, h);
+    char *base = static_cast<char *>(dst);
+    memset(base, 0, h.total_bytes);
+
+    memcpy(base + h.class_offset, aho.byte_class, sizeof(aho.byte_class));
+    memcpy(base + h.next_offset, aho.next.data(), aho.next.size() * sizeof(int32_t));
+
+    uint32_t *out_begin = reinterpret_cast<uint32_t *>(base + h.out_begin_offset);
+    int32_t *out = reinterpret_cast<int32_t *>(base + h.out_offset);
+    uint32_t pos = 0;
+    for (int32_t v = 0; v < h.states; ++v) {
+        out_begin[v] = pos;
+        for (int idx : aho.trie[v].out) out[pos++] = idx;
+    }
+    out_begin[h.states] = pos;
+
+    if (h.patterns > 0) {
+        memcpy(base + h.len_offset, aho.pattern_len.data(), h.patterns * sizeof(int32_t));
+    }
+
+    // magic записується останнім, щоб напівзаписаний образ не пройшов attach
+    uint32_t magic = h.magic;
+    h.magic = 0;
+    memcpy(base, &h, sizeof(h));
+    atomic_thread_fence(memory_order_release);
+    memcpy(base, &magic, sizeof(magic));
+}
+
+/**
+ * @brief Створює неприєднане подання.
+ */
+FlatAutomatonView::FlatAutomatonView()
+    : header(nullptr), byte_class(nullptr), next(nullptr), out_begin(nullptr), out(nullptr),
+      pattern_len(nullptr) {}
+
+/**
+ * @brief Приєднує образ.
+ *
+ * Перевіряє заголовок, межі масивів, переходи та індекси шаблонів, щоб
+ * пошкоджений сегмент не призвів до читання поза відображенням.
+ *
+ * @param base Початок образу.
+ * @param size Доступний розмір.
+ * @return true, якщо образ коректний.
+ */
+bool FlatAutomatonView::attach(const void *base, size_t size) {
+    header = nullptr;
+    if (size < sizeof(FlatHeader)) return false;
+    const FlatHeader *h = static_cast<const FlatHeader *>(base);
+    if (h->magic != FLAT_MAGIC || h->version != FLAT_VERSION) return false;
+    atomic_thread_fence(memory_order_acquire);
+
+    FlatHeader expected;
+    if (h->states < 1 || h->alpha < 1 || h->patterns < 0 || h->total_bytes > size) return false;
+    expected.class_offset = align64(sizeof(FlatHeader));
+    expected.next_offset = align64(expected.class_offset + 256 * sizeof(uint16_t));
+    expected.out_begin_offset = align64(expected.next_offset + (uint64_t)h->states * h->alpha * sizeof(int32_t));
+    expected.out_offset = align64(expected.out_begin_offset + ((uint64_t)h->states + 1) * sizeof(uint32_t));
+    if (h->class_offset != expected.class_offset || h->next_offset != expected.next_offset ||
+        h->out_begin_offset != expected.out_begin_offset || h->out_offset != expected.out_offset) {
+        return false;
+    }
+    if (h->out_offset > h->total_bytes) return false;
+
+    const char *p = static_cast<const char *>(base);
+    const uint16_t *cls = reinterpret_cast<const uint16_t *>(p + h->class_offset);
+    const int32_t *delta = reinterpret_cast<const int32_t *>(p + h->next_offset);
+    const uint32_t *begin = reinterpret_cast<const uint32_t *>(p + h->out_begin_offset);
+    const int32_t *outs = reinterpret_cast<const int32_t *>(p + h->out_offset);
+    const int32_t *lens = reinterpret_cast<const int32_t *>(p + h->len_offset);
+
+    uint64_t outputs = begin[h->states];
+    if (h->len_offset != align64(h->out_offset + outputs * sizeof(int32_t))) return false;
+    if (h->len_offset + (uint64_t)h->patterns * sizeof(int32_t) > h->total_bytes) return false;
+
+    for (int c = 0; c < 256; ++c) {
+        if (cls[c] >= h->alpha) return false;
+    }
+    for (uint64_t i = 0; i < (uint64_t)h->states * h->alpha; ++i) {
+        if (delta[i] < 0 || delta[i] >= h->states) return false;
+    }
+    for (int32_t v = 0; v < h->states; ++v) {
+        if (begin[v] > begin[v + 1]) return false;
+    }
+    for (uint64_t i = 0; i < outputs; ++i) {
+        if (outs[i] < 0 || outs[i] >= h->patterns) return false;
+    }
+
+    header = h;
+    byte_class = cls;
+    next = delta;
+    out_begin = begin;
+    out = outs;
+    pattern_len = lens;
+    return true;
+}
+
+/**
+ * @brief Доступ до масивів образу автомата для scan_loop.
+ */
+struct FlatAccess {
+    const int32_t *delta;      ///< Переходи.
+    const uint16_t *cls;       ///< Класи байтів.
+    const uint32_t *begin;     ///< Межі списків виходів.
+    const int32_t *outs;       ///< Списки виходів.
+    const int32_t *len;        ///< Довжини шаблонів.
+    int alpha;                 ///< Кількість класів.
+    Scope scope;               ///< Семантика меж збігу.
+
+    explicit FlatAccess(const FlatAutomatonView &view)
+        : delta(view.next), cls(view.byte_class), begin(view.out_begin), outs(view.out),
+          len(view.pattern_len), alpha(view.header->alpha), scope((Scope)view.header->scope) {}
+
+    int step(int v, unsigned char c) const { return delta[v * alpha + cls[c]]; }
+    const int32_t *out_begin(int v) const { return outs + begin[v]; }
+    const int32_t *out_end(int v) const { return outs + begin[v + 1]; }
+    int pattern_len(int idx) const { return len[idx]; }
+};
+
+/**
+ * @brief Пошук за образом автомата.
+ *
+ * Той самий scan_loop, що й у AhoCorasick, лише з доступом до масивів образу.
+ *
+ * @param text Текст для пошуку.
+ * @param per_pattern Вектор, у який записується кількість входжень кожного шаблону.
+ * @return Загальна кількість входжень усіх шаблонів.
+ */
+size_t FlatAutomatonView::search(const string &text, vector<size_t> &per_pattern) const {
+    per_pattern.assign(header ? header->patterns : 0, 0);
+    if (!header) return 0;
+
+    size_t *counts = per_pattern.data();
+    ScanState st = {0, 0};
+    return scan_loop(FlatAccess(*this), text.data(), 0, 0, text.size(), true, st, [&](size_t, int pattern_idx) {
+        ++counts[pattern_idx];
+        return true;
+    });
+}
+
+/**
+ * @brief Створює об'єкт без відображення.
+ */
+SharedAutomaton::SharedAutomaton() : base(nullptr), size(0) {}
+
+/**
+ * @brief Знімає відображення.
+ */
+SharedAutomaton::~SharedAutomaton() {
+    detach();
+}
+
+#ifdef __unix__
+/**
+ * @brief Записує образ автомата в новий сегмент спільної пам'яті.
+ * @param name Ім'я сегмента.
+ * @param aho Побудований автомат.
+ * @return true, якщо сегмент створено.
+ */
+bool SharedAutomaton::publish(const string &name, const AhoCorasick &aho) {
+    size_t bytes = flat_size(aho);
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void *mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+    write_flat(aho, mem);
+    munmap(mem, bytes);
+    return true;
+}
+
+/**
+ * @brief Видаляє сегмент.
+ * @param name Ім'я сегмента.
+ * @return true, якщо сегмент видалено.
+ */
+bool SharedAutomaton::remove(const string &name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+/**
+ * @brief Приєднує сегмент лише для читання.
+ * @param name Ім'я сегмента.
+ * @return true, якщо образ коректний.
+ */
+bool SharedAutomaton::attach(const string &name) {
+    detach();
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void *mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return false;
+
+    base = mem;
+    size = (size_t)st.st_size;
+    if (!view.attach(base, size)) {
+        detach();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Знімає відображення.
+ */
+void SharedAutomaton::detach() {
+    if (base) munmap(base, size);
+    base = nullptr;
+    size = 0;
+    view = FlatAutomatonView();
+}
+#else
+bool SharedAutomaton::publish(const string &, const AhoCorasick &) { return false; }
+bool SharedAutomaton::remove(const string &) { return false; }
+bool SharedAutomaton::attach(const string &) { return false; }
+void SharedAutomaton::detach() {
+    base = nullptr;
+    size = 0;
+    view = FlatAutomatonView();
+}
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+#include "search_algorithms.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Заголовок образу автомата без вказівників.
+ *
+ * Усі масиви образу адресуються зміщеннями від його початку, тож образ
+ * можна відобразити за будь-якою адресою в будь-якому процесі. Масиви
+ * вирівняні на 64 байти.
+ */
+struct FlatHeader {
+    uint32_t magic;        ///< FLAT_MAGIC.
+    uint32_t version;      ///< FLAT_VERSION.
+    uint64_t total_bytes;  ///< Розмір усього образу.
+    int32_t states;        ///< Кількість вершин.
+    int32_t alpha;         ///< Кількість класів байтів.
+    int32_t patterns;      ///< Кількість шаблонів.
+    int32_t max_len;       ///< Найбільша довжина шаблону.
+    int32_t case_mode;     ///< MatchOptions::case_mode.
+    int32_t scope;         ///< MatchOptions::scope.
+    uint64_t class_offset; ///< uint16_t[256]: клас кожного байта.
+    uint64_t next_offset;  ///< int32_t[states * alpha]: переходи.
+    uint64_t out_begin_offset; ///< uint32_t[states + 1]: початок виходів вершини в out.
+    uint64_t out_offset;   ///< int32_t[...]: індекси шаблонів, що закінчуються у вершинах.
+    uint64_t len_offset;   ///< int32_t[patterns]: довжини шаблонів.
+};
+
+const uint32_t FLAT_MAGIC = 0x4b484f41; ///< "AOHK" у little-endian.
+const uint32_t FLAT_VERSION = 1;        ///< Версія формату образу.
+
+/**
+ * @brief Обчислює розмір образу автомата.
+ * @param aho Побудований автомат.
+ * @return Розмір у байтах.
+ */
+size_t flat_size(const AhoCorasick &aho);
+
+/**
+ * @brief Записує образ автомата в пам'ять.
+ *
+ * Шаблони як рядки не записуються: для пошуку потрібні лише їхні довжини.
+ *
+ * @param aho Побудований автомат.
+ * @param dst Буфер розміром щонайменше flat_size(aho), вирівняний на 64 байти.
+ */
+void write_flat(const AhoCorasick &aho, void *dst);
+
+/**
+ * @brief Пошук за образом автомата без копіювання.
+ *
+ * Має ту саму семантику, що й AhoCorasick::search для автомата, з якого
+ * записано образ.
+ */
+struct FlatAutomatonView {
+    const FlatHeader *header;         ///< Заголовок образу (nullptr, якщо не приєднано).
+    const uint16_t *byte_class;       ///< Класи байтів.
+    const int32_t *next;              ///< Переходи.
+    const uint32_t *out_begin;        ///< Межі списків виходів.
+    const int32_t *out;               ///< Списки виходів.
+    const int32_t *pattern_len;       ///< Довжини шаблонів.
+
+    /**
+     * @brief Створює неприєднане подання.
+     */
+    FlatAutomatonView();
+
+    /**
+     * @brief Приєднує образ і перевіряє його заголовок та межі масивів.
+     * @param base Початок образу.
+     * @param size Доступний розмір.
+     * @return true, якщо образ коректний.
+     */
+    bool attach(const void *base, size_t size);
+
+    /**
+     * @brief Виконує пошук усіх шаблонів у тексті.
+     * @param text Текст для пошуку.
+     * @param per_pattern Вектор, у який записується кількість входжень кожного шаблону.
+     * @return Загальна кількість входжень усіх шаблонів.
+     */
+    size_t search(const std::string &text, std::vector<size_t> &per_pattern) const;
+};
+
+/**
+ * @brief Образ автомата в сегменті спільної пам'яті POSIX.
+ *
+ * Один процес будує автомат і публікує образ через publish(); інші
+ * приєднуються через attach() лише для читання й шукають безпосередньо
+ * у відображеній пам'яті, тож фізична копія автомата одна на хост.
+ * Сегмент існує, доки його не видалено remove(), навіть після завершення
+ * процесу-творця.
+ */
+struct SharedAutomaton {
+    void *base;              ///< Відображення сегмента (nullptr, якщо немає).
+    size_t size;             ///< Розмір відображення.
+    FlatAutomatonView view;  ///< Подання для пошуку.
+
+    /**
+     * @brief Створює об'єкт без відображення.
+     */
+    SharedAutomaton();
+
+    /**
+     * @brief Знімає відображення.
+     */
+    ~SharedAutomaton();
+
+    SharedAutomaton(const SharedAutomaton &) = delete;
+    SharedAutomaton &operator=(const SharedAutomaton &) = delete;
+
+    /**
+     * @brief Записує образ автомата в новий сегмент.
+     *
+     * Образ записується з magic = 0, а magic встановлюється останнім:
+     * процес, що приєднався надто рано, отримає відмову, а не напівзаписаний
+     * автомат.
+     *
+     * @param name Ім'я сегмента (починається з '/').
+     * @param aho Побудований автомат.
+     * @return true, якщо сегмент створено; false, якщо він уже існує або сталася помилка.
+     */
+    static bool publish(const std::string &name, const AhoCorasick &aho);
+
+    /**
+     * @brief Видаляє сегмент (наявні відображення лишаються дійсними).
+     * @param name Ім'я сегмента.
+     * @return true, якщо сегмент видалено.
+     */
+    static bool remove(const std::string &name);
+
+    /**
+     * @brief Приєднує сегмент лише для читання.
+     * @param name Ім'я сегмента.
+     * @return true, якщо сегмент існує і містить коректний образ.
+     */
+    bool attach(const std::string &name);
+
+    /**
+     * @brief Знімає відображення, якщо воно є.
+     */
+    void detach();
+};
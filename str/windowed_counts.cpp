@@ -0,0 +1,118 @@
+#include "windowed_counts.hpp"
+#include <algorithm>
+using namespace std;
+
+/**
+ * @brief Створює порожнє вікно.
+ * @param aho Побудований автомат.
+ * @param bucket_width_ Ширина кошика.
+ * @param window_buckets Кількість кошиків у вікні.
+ */
+WindowedCounts::WindowedCounts(const AhoCorasick &aho, uint64_t bucket_width_, size_t window_buckets)
+    : scanner(aho), bucket_width(bucket_width_ ? bucket_width_ : 1), current(0), started(false),
+      ring(window_buckets ? window_buckets : 1), window(aho.patterns.size(), 0), window_total(0) {
+    open.reset(aho.patterns.size());
+    fresh.reset(aho.patterns.size());
+}
+
+/**
+ * @brief Переносить збіги відкритого кошика в його комірку кільця.
+ *
+ * Індекси сортуються, щоб кошик був компактним і впорядкованим; щільний
+ * масив open обнуляється лише в зачеплених елементах.
+ *
+ * @param w Вікно.
+ */
+static void seal_open(WindowedCounts &w) {
+    WindowedCounts::Bucket &b = w.ring[w.current % w.ring.size()];
+    sort(w.open.touched.begin(), w.open.touched.end());
+    b.index = w.current;
+    b.patterns = w.open.touched;
+    b.counts.resize(b.patterns.size());
+    for (size_t i = 0; i < b.patterns.size(); ++i) b.counts[i] = w.open.counts[b.patterns[i]];
+    b.total = w.open.total;
+    w.open.reset(w.window.size());
+}
+
+/**
+ * @brief Віднімає кошик від лічильників вікна й очищає його.
+ * @param w Вікно.
+ * @param b Кошик, що вийшов із вікна.
+ */
+static void expire(WindowedCounts &w, WindowedCounts::Bucket &b) {
+    for (size_t i = 0; i < b.patterns.size(); ++i) w.window[b.patterns[i]] -= b.counts[i];
+    w.window_total -= b.total;
+    b.patterns.clear();
+    b.counts.clear();
+    b.total = 0;
+}
+
+/**
+ * @brief Пересуває вікно.
+ *
+ * Відкриття кошика k витісняє кошик k - N із тієї ж комірки кільця; за
+ * стрибка часу, довшого за вікно, очищається все кільце.
+ *
+ * @param time Поточний час.
+ */
+void WindowedCounts::advance(uint64_t time) {
+    uint64_t target = time / bucket_width;
+    if (!started) {
+        started = true;
+        current = target;
+        return;
+    }
+    if (target <= current) return;
+
+    seal_open(*this);
+    uint64_t steps = min<uint64_t>(target - current, ring.size());
+    for (uint64_t k = target - steps + 1; k <= target; ++k) expire(*this, ring[k % ring.size()]);
+    current = target;
+}
+
+/**
+ * @brief Сканує фрагмент і додає його збіги до поточного кошика та вікна.
+ *
+ * Фрагмент сканується в окремий розріджений результат, тож до кошика й
+ * вікна додаються лише лічильники, зачеплені цим фрагментом.
+ *
+ * @param time Час надходження.
+ * @param data Байти фрагмента.
+ * @param size Кількість байтів.
+ * @return Кількість входжень у фрагменті.
+ */
+size_t WindowedCounts::feed(uint64_t time, const char *data, size_t size) {
+    advance(time);
+
+    fresh.reset(window.size());
+    size_t found = scanner.feed(data, size, fresh);
+    for (int idx : fresh.touched) {
+        size_t c = fresh.counts[idx];
+        window[idx] += c;
+        if (open.counts[idx] == 0) open.touched.push_back(idx);
+        open.counts[idx] += c;
+    }
+    open.total += found;
+    window_total += found;
+    return found;
+}
+
+/**
+ * @brief Сканує фрагмент-рядок.
+ * @param time Час надходження.
+ * @param chunk Фрагмент.
+ * @return Кількість входжень у фрагменті.
+ */
+size_t WindowedCounts::feed(uint64_t time, const string &chunk) {
+    return feed(time, chunk.data(), chunk.size());
+}
+
+/**
+ * @brief Кількість входжень шаблону у вікні.
+ * @param pattern Індекс шаблону.
+ * @return Кількість входжень.
+ */
+size_t WindowedCounts::count(int pattern) const {
+    if (pattern < 0 || (size_t)pattern >= window.size()) return 0;
+    return window[pattern];
+}
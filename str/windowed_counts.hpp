@@ -0,0 +1,80 @@
+#pragma once
+#include "search_algorithms.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Кількість входжень шаблонів за останні N часових кошиків потоку.
+ *
+ * Час ділиться на кошики шириною bucket_width (одиниці часу обирає
+ * викликач: секунди, мілісекунди тощо); вікно — поточний кошик і
+ * window_buckets - 1 попередніх. Текст сканується один раз при надходженні
+ * через StreamScanner, а збіги одразу додаються до лічильників вікна.
+ * Закритий кошик зберігається в кільцевому буфері як розріджений список
+ * (шаблон, кількість), і коли він виходить із вікна, його лічильники
+ * віднімаються. Тож вартість оновлення пропорційна новим байтам і
+ * кількості різних шаблонів у кошиках, що вийшли, а не розміру вікна.
+ *
+ * Дані з міткою часу до початку поточного кошика (що надійшли не за
+ * порядком) зараховуються до поточного кошика.
+ */
+struct WindowedCounts {
+    /**
+     * @brief Закритий кошик: ненульові лічильники за зростанням індексу шаблону.
+     */
+    struct Bucket {
+        uint64_t index;               ///< Номер кошика (час / bucket_width).
+        std::vector<int> patterns;    ///< Шаблони з входженнями.
+        std::vector<size_t> counts;   ///< Кількість входжень кожного з них.
+        size_t total;                 ///< Загальна кількість входжень у кошику.
+    };
+
+    StreamScanner scanner;        ///< Сканер потоку.
+    uint64_t bucket_width;        ///< Ширина кошика в одиницях часу.
+    uint64_t current;             ///< Номер поточного (відкритого) кошика.
+    bool started;                 ///< Чи надходили вже дані або advance().
+    std::vector<Bucket> ring;     ///< Кільце кошиків; кошик k лежить у ring[k % ring.size()].
+    SparseCounts open;            ///< Збіги поточного кошика.
+    SparseCounts fresh;           ///< Збіги останнього фрагмента.
+    std::vector<size_t> window;   ///< Кількість входжень кожного шаблону у вікні.
+    size_t window_total;          ///< Загальна кількість входжень у вікні.
+
+    /**
+     * @brief Створює порожнє вікно.
+     * @param aho Побудований автомат; має жити довше за вікно.
+     * @param bucket_width_ Ширина кошика в одиницях часу (не менше 1).
+     * @param window_buckets Кількість кошиків у вікні (не менше 1).
+     */
+    WindowedCounts(const AhoCorasick &aho, uint64_t bucket_width_, size_t window_buckets);
+
+    /**
+     * @brief Пересуває вікно до моменту time, відкидаючи кошики, що вийшли з нього.
+     * @param time Поточний час.
+     */
+    void advance(uint64_t time);
+
+    /**
+     * @brief Сканує наступний фрагмент потоку, що надійшов у момент time.
+     * @param time Час надходження.
+     * @param data Байти фрагмента.
+     * @param size Кількість байтів.
+     * @return Кількість входжень, знайдених у фрагменті.
+     */
+    size_t feed(uint64_t time, const char *data, size_t size);
+
+    /**
+     * @brief Сканує наступний фрагмент потоку, що надійшов у момент time.
+     * @param time Час надходження.
+     * @param chunk Фрагмент.
+     * @return Кількість входжень, знайдених у фрагменті.
+     */
+    size_t feed(uint64_t time, const std::string &chunk);
+
+    /**
+     * @brief Повертає кількість входжень шаблону у вікні.
+     * @param pattern Індекс шаблону.
+     * @return Кількість входжень або 0, якщо індекс поза межами.
+     */
+    size_t count(int pattern) const;
+};
@@ -0,0 +1,367 @@
+// Диференційний фаззер: кожен рушій пошуку порівнюється з еталоном,
+// побудованим на naive_search, для кожної семантики MatchOptions;
+// сам naive_search перевіряється побайтовим порівнянням за визначенням.
+//
+// libFuzzer:   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address
+//                  -DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+//                  tests/fuzz_search.cpp src/search_algorithms.cpp src/corpus_generator.cpp
+// Без libFuzzer: той самий файл без -fsanitize=fuzzer і без макроса дає
+//                 програму, що перевіряє випадкові входи: fuzz_search [iterations] [seed]
+
+#include "../src/search_algorithms.hpp"
+#include "../src/corpus_generator.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---------------------- Еталон ----------------------
+
+static bool ref_word_byte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+static unsigned char fold(unsigned char c, const MatchOptions &options) {
+    if (options.case_mode == CaseMode::AsciiFold && c >= 'A' && c <= 'Z') return c + 32;
+    return c;
+}
+
+/**
+ * @brief Чи складається рядок із цілих символів UTF-8.
+ */
+static bool is_valid_utf8(const string &s) {
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = (unsigned char)s[i];
+        size_t len = c < 0x80 ? 1 : c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3
+                   : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+        if (len == 0 || i + len > s.size()) return false;
+        for (size_t j = 1; j < len; ++j) {
+            if (((unsigned char)s[i + j] & 0xC0) != 0x80) return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+/**
+ * @brief Побайтове порівняння за визначенням семантики — незалежна
+ * перевірка самого naive_search.
+ */
+static size_t brute_force(const string &text, const vector<string> &patterns,
+                          const MatchOptions &options, vector<size_t> &per_pattern,
+                          vector<Match> *matches = nullptr) {
+    per_pattern.assign(patterns.size(), 0);
+    size_t total = 0;
+    // для UnicodeFold текст і шаблони згортаються заздалегідь, решта — побайтово
+    bool unicode = options.case_mode == CaseMode::UnicodeFold;
+    const string hay = unicode ? fold_case(text, options.case_mode) : text;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        string p;
+        for (unsigned char c : patterns[i]) {
+            if (options.scope != Scope::Substring && !ref_word_byte(c)) continue;
+            p += (char)fold(c, options);
+        }
+        if (unicode) p = fold_case(p, options.case_mode);
+        if (p.empty()) continue;
+
+        for (size_t pos = 0; pos + p.size() <= hay.size(); ++pos) {
+            bool ok = true;
+            for (size_t j = 0; j < p.size() && ok; ++j) {
+                unsigned char c = (unsigned char)hay[pos + j];
+                if (options.scope != Scope::Substring && !ref_word_byte(c)) ok = false;
+                if (fold(c, options) != (unsigned char)p[j]) ok = false;
+            }
+            if (ok && options.scope == Scope::WholeWord) {
+                size_t end = pos + p.size();
+                if (pos > 0 && ref_word_byte(hay[pos - 1])) ok = false;
+                if (end < hay.size() && ref_word_byte(hay[end])) ok = false;
+            }
+            if (ok) {
+                ++per_pattern[i];
+                ++total;
+                if (matches) matches->push_back({pos, p.size(), (int)i});
+            }
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Відбір збігів за політикою перекриття з повного списку.
+ *
+ * Збіги впорядковуються за пріоритетом режиму й відбираються жадібно:
+ * кожен наступний має починатися після кінця попереднього.
+ */
+static vector<Match> select_matches(vector<Match> all, MatchKind kind) {
+    auto key = [&](const Match &a, const Match &b) {
+        if (kind == MatchKind::Overlapping || kind == MatchKind::NonOverlapping) {
+            if (a.pos + a.len != b.pos + b.len) return a.pos + a.len < b.pos + b.len;
+            if (a.len != b.len) return a.len > b.len;
+            return a.pattern < b.pattern;
+        }
+        if (a.pos != b.pos) return a.pos < b.pos;
+        if (kind == MatchKind::LeftmostLongest && a.len != b.len) return a.len > b.len;
+        return a.pattern < b.pattern;
+    };
+    sort(all.begin(), all.end(), key);
+    if (kind == MatchKind::Overlapping) return all;
+
+    vector<Match> out;
+    size_t next_start = 0;
+    for (const Match &m : all) {
+        if (m.pos < next_start) continue;
+        out.push_back(m);
+        next_start = m.pos + m.len;
+    }
+    return out;
+}
+
+static bool same_matches(const vector<Match> &a, const vector<Match> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].pos != b[i].pos || a[i].len != b[i].len || a[i].pattern != b[i].pattern) return false;
+    }
+    return true;
+}
+
+// ---------------------- Перевірки ----------------------
+
+static void fail(const char *engine, const string &text, const vector<string> &patterns,
+                 const MatchOptions &options) {
+    fprintf(stderr, "MISMATCH in %s (case_mode %d, scope %d)\ntext (%zu bytes): \"%s\"\npatterns:",
+            engine, (int)options.case_mode, (int)options.scope, text.size(), text.c_str());
+    for (const string &p : patterns) fprintf(stderr, " \"%s\"", p.c_str());
+    fprintf(stderr, "\n");
+    abort();
+}
+
+#define EXPECT(cond, engine) \
+    do { if (!(cond)) fail(engine, text, patterns, options); } while (0)
+
+static void check_engines(const string &text, const vector<string> &patterns,
+                          const MatchOptions &options) {
+    // наївні рушії проти визначення
+    vector<size_t> ref;
+    vector<Match> all_matches;
+    size_t ref_total = brute_force(text, patterns, options, ref, &all_matches);
+
+    vector<size_t> naive;
+    EXPECT(naive_search(text, patterns, naive, options) == ref_total && naive == ref, "naive_search");
+
+    SparseCounts naive_sparse;
+    EXPECT(naive_search(text, patterns, naive_sparse, options) == ref_total, "naive_search(sparse)");
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        EXPECT(naive_sparse.count((int)i) == ref[i], "naive_search(sparse)");
+    }
+
+    // автомат проти naive_search
+    AhoCorasick aho;
+    aho.build_automaton(patterns, options);
+
+    vector<size_t> counts;
+    EXPECT(aho.search(text, counts) == ref_total && counts == ref, "AhoCorasick::search");
+
+    vector<size_t> acc(patterns.size(), 1);
+    EXPECT(aho.accumulate(text, acc.data()) == ref_total, "AhoCorasick::accumulate");
+    for (size_t i = 0; i < patterns.size(); ++i) EXPECT(acc[i] == ref[i] + 1, "AhoCorasick::accumulate");
+
+    SparseCounts sparse;
+    aho.search("ab aab ba", sparse); // результат попереднього пошуку не повинен вплинути
+    EXPECT(aho.search(text, sparse) == ref_total, "AhoCorasick::search(sparse)");
+    for (size_t i = 0; i < patterns.size(); ++i) EXPECT(sparse.count((int)i) == ref[i], "AhoCorasick::search(sparse)");
+
+    for (unsigned workers : {2u, 3u, 5u}) {
+        vector<size_t> par;
+        EXPECT(parallel_search(aho, text, par, workers) == ref_total && par == ref, "parallel_search");
+    }
+
+    // режим записів: кожен рядок окремо
+    vector<size_t> record_sum(patterns.size(), 0);
+    size_t record_total = aho.search_records(text, [&](size_t, size_t begin, size_t end,
+                                                       const SparseCounts &hits) {
+        vector<size_t> line_ref;
+        size_t line_total = naive_search(text.substr(begin, end - begin), patterns, line_ref, options);
+        EXPECT(hits.total == line_total, "AhoCorasick::search_records");
+        for (size_t i = 0; i < patterns.size(); ++i) {
+            EXPECT(hits.count((int)i) == line_ref[i], "AhoCorasick::search_records");
+            record_sum[i] += hits.count((int)i);
+        }
+    });
+    // збіги через '\n' у режимі підрядка режим записів не бачить
+    if (options.scope == Scope::Substring && text.find('\n') != string::npos) {
+        EXPECT(record_total <= ref_total, "AhoCorasick::search_records");
+    } else {
+        EXPECT(record_total == ref_total && record_sum == ref, "AhoCorasick::search_records");
+    }
+
+    // рання зупинка
+    EXPECT(aho.contains_any(text) == (ref_total > 0), "AhoCorasick::contains_any");
+    Match m;
+    bool found = aho.first_match(text, m);
+    EXPECT(found == (ref_total > 0), "AhoCorasick::first_match");
+    if (found) {
+        vector<size_t> prefix_ref;
+        size_t end = m.pos + m.len;
+        EXPECT(m.pattern >= 0 && (size_t)m.pattern < patterns.size(), "AhoCorasick::first_match");
+        // для цілих слів обрізаний текст закінчується на межі слова перед збігом
+        size_t prefix = options.scope == Scope::WholeWord ? m.pos : end - 1;
+        EXPECT(naive_search(text.substr(0, prefix), patterns, prefix_ref, options) == 0,
+               "AhoCorasick::first_match");
+        naive_search(text.substr(m.pos, m.len), patterns, prefix_ref, options);
+        EXPECT(prefix_ref[m.pattern] == 1, "AhoCorasick::first_match");
+    }
+
+    // політики перекриття
+    for (MatchKind kind : {MatchKind::Overlapping, MatchKind::NonOverlapping,
+                           MatchKind::LeftmostFirst, MatchKind::LeftmostLongest}) {
+        vector<Match> got;
+        size_t n = aho.find_matches(text, kind, [&](const Match &hit) { got.push_back(hit); });
+        vector<Match> expected = select_matches(all_matches, kind);
+        if (kind == MatchKind::Overlapping) got = select_matches(got, kind);
+        EXPECT(n == got.size() && same_matches(got, expected), "AhoCorasick::find_matches");
+    }
+
+    // заміна: шаблон i -> "<i>", шаблони без заміни лишаються як є
+    vector<string> replacements;
+    for (size_t i = 0; i + 1 < patterns.size(); ++i) replacements.push_back("<" + to_string(i) + ">");
+    string rewritten, expected_text;
+    size_t replaced = replace_all(aho, text, replacements, [&](const char *data, size_t size) {
+        rewritten.append(data, size);
+    });
+    size_t expected_replaced = 0, copied = 0;
+    for (const Match &r : select_matches(all_matches, MatchKind::LeftmostLongest)) {
+        if ((size_t)r.pattern >= replacements.size()) continue;
+        expected_text += text.substr(copied, r.pos - copied) + replacements[r.pattern];
+        copied = r.pos + r.len;
+        ++expected_replaced;
+    }
+    expected_text += text.substr(copied);
+    EXPECT(replaced == expected_replaced && rewritten == expected_text, "replace_all");
+
+    for (size_t k : {1u, 2u, 3u}) {
+        bool expected = true;
+        for (size_t c : ref) expected = expected && c >= k;
+        EXPECT(aho.all_reach(text, k) == expected, "AhoCorasick::all_reach");
+    }
+}
+
+static const MatchOptions ALL_OPTIONS[] = {
+    {CaseMode::Sensitive, Scope::Substring},
+    {CaseMode::AsciiFold, Scope::Substring},
+    {CaseMode::Sensitive, Scope::WithinWord},
+    {CaseMode::AsciiFold, Scope::WithinWord},
+    {CaseMode::UnicodeFold, Scope::Substring},
+    {CaseMode::UnicodeFold, Scope::WithinWord},
+    {CaseMode::Sensitive, Scope::WholeWord},
+    {CaseMode::AsciiFold, Scope::WholeWord},
+    {CaseMode::UnicodeFold, Scope::WholeWord},
+};
+
+static void check_all(const string &text, const vector<string> &patterns) {
+    // UnicodeFold визначено лише для шаблонів із цілих символів UTF-8
+    bool valid = true;
+    for (const string &p : patterns) valid = valid && is_valid_utf8(p);
+    for (const MatchOptions &options : ALL_OPTIONS) {
+        if (options.case_mode == CaseMode::UnicodeFold && !valid) continue;
+        check_engines(text, patterns, options);
+    }
+}
+
+// ---------------------- Декодування входу ----------------------
+
+/**
+ * @brief Розбирає сирі байти на словник і текст.
+ *
+ * Перший байт — кількість шаблонів (до 15); далі шаблони, розділені
+ * байтом '\0'; решта — текст.
+ */
+static void decode(const uint8_t *data, size_t size, vector<string> &patterns, string &text) {
+    if (size == 0) return;
+    size_t n = data[0] % 16;
+    size_t pos = 1;
+    while (patterns.size() < n && pos <= size) {
+        string p;
+        while (pos < size && data[pos] != 0 && p.size() < 32) p += (char)data[pos++];
+        ++pos;
+        patterns.push_back(p);
+    }
+    if (pos < size) text.assign(reinterpret_cast<const char *>(data + pos), size - pos);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    vector<string> patterns;
+    string text;
+    decode(data, size, patterns, text);
+    check_all(text, patterns);
+    return 0;
+}
+
+#ifndef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+// ---------------------- Автономний режим ----------------------
+
+/**
+ * @brief Випадковий рядок із малого алфавіту, щоб збіги перекривалися часто.
+ */
+static string random_string(CorpusRng &rng, size_t max_len, const char *alphabet) {
+    size_t n = strlen(alphabet);
+    size_t len = rng.below(max_len + 1);
+    string s;
+    for (size_t i = 0; i < len; ++i) {
+        // зрідка — довільний байт, зокрема не-ASCII
+        if (rng.below(50) == 0) s += (char)rng.below(256);
+        else s += alphabet[rng.below(n)];
+    }
+    return s;
+}
+
+/**
+ * @brief Випадковий рядок із символів UTF-8, що мають велику й малу форми.
+ */
+static string random_utf8(CorpusRng &rng, size_t max_len) {
+    static const char *const tokens[] = {
+        "a", "A", "д", "Д", "ї", "Ї", "é", "É", "ѐ", "Ѐ", "ґ", "Ґ", "ÿ", "Ÿ", "-", " ", "\n",
+    };
+    size_t n = sizeof(tokens) / sizeof(tokens[0]);
+    size_t len = rng.below(max_len + 1);
+    string s;
+    for (size_t i = 0; i < len; ++i) {
+        // зрідка — довільний байт, зокрема обірвана послідовність UTF-8
+        if (rng.below(50) == 0) s += (char)rng.below(256);
+        else s += tokens[rng.below(n)];
+    }
+    return s;
+}
+
+int main(int argc, char **argv) {
+    size_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+    CorpusRng rng(seed);
+
+    for (size_t it = 0; it < iterations; ++it) {
+        vector<string> patterns;
+        size_t n = rng.below(8);
+        for (size_t i = 0; i < n; ++i) patterns.push_back(random_string(rng, 5, "abaAB-"));
+        if (n > 0 && rng.below(4) == 0) patterns.push_back(patterns[rng.below(n)]); // дублікат
+        string text = random_string(rng, 120, "aabbAB \n,-");
+        check_all(text, patterns);
+
+        patterns.clear();
+        n = rng.below(6);
+        for (size_t i = 0; i < n; ++i) {
+            string p = random_utf8(rng, 4);
+            if (is_valid_utf8(p)) patterns.push_back(p);
+        }
+        check_all(random_utf8(rng, 80), patterns);
+    }
+
+    printf("fuzz_search: %zu random cases passed (seed %llu)\n", iterations,
+           (unsigned long long)seed);
+    return 0;
+}
+#endif
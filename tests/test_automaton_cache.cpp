@@ -0,0 +1,103 @@
+#include "doctest.h"
+
+#include "../src/automaton_cache.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// ---- Хеш словника ----
+TEST_CASE("Dictionary hash depends on content, order and options") {
+    MatchOptions options;
+    CHECK(dictionary_hash({"ab", "c"}, options) == dictionary_hash({"ab", "c"}, options));
+    CHECK(dictionary_hash({"ab", "c"}, options) != dictionary_hash({"a", "bc"}, options));
+    CHECK(dictionary_hash({"ab", "c"}, options) != dictionary_hash({"c", "ab"}, options));
+    CHECK(dictionary_hash({"ab"}, options) != dictionary_hash({"ab"}, {CaseMode::AsciiFold, Scope::Substring}));
+}
+
+// ---- Повторний запит не будує автомат ----
+TEST_CASE("Cache returns the same automaton for the same dictionary") {
+    AutomatonCache cache(1 << 20);
+    AutomatonCache::Handle a = cache.get({"cat", "dog"});
+    AutomatonCache::Handle b = cache.get({"cat", "dog"});
+    AutomatonCache::Handle c = cache.get({"cat", "dog"}, MatchOptions());
+
+    CHECK(a == b);
+    CHECK(a != c);
+    AutomatonCacheStats st = cache.stats();
+    CHECK(st.hits == 1);
+    CHECK(st.misses == 2);
+    CHECK(st.entries == 2);
+    CHECK(st.bytes == a->stats().total_bytes + c->stats().total_bytes);
+
+    vector<size_t> counts;
+    CHECK(a->search("Cat and DOG", counts) == 2);
+}
+
+// ---- Витіснення за бюджетом ----
+TEST_CASE("Least recently used automata are evicted over budget") {
+    vector<string> d1 = {"alpha", "beta"}, d2 = {"gamma", "delta"}, d3 = {"epsilon"};
+    size_t one = AutomatonCache(1 << 20).get(d1)->stats().total_bytes;
+
+    AutomatonCache cache(one * 2 + one / 2);
+    AutomatonCache::Handle first = cache.get(d1);
+    cache.get(d2);
+    cache.get(d1); // d1 стає найновішим
+    cache.get(d3);
+
+    AutomatonCacheStats st = cache.stats();
+    CHECK(st.evictions == 1);
+    CHECK(st.entries == 2);
+    CHECK(st.bytes <= one * 2 + one / 2);
+    CHECK(cache.get(d1) == first); // d2 витіснено, d1 лишився
+    CHECK(cache.stats().misses == 3);
+
+    // витіснений автомат лишається дійсним для того, хто ним користується
+    cache.clear();
+    vector<size_t> counts;
+    CHECK(first->search("alpha beta", counts) == 2);
+    CHECK(cache.stats().entries == 0);
+}
+
+// ---- Паралельні запити ----
+TEST_CASE("Concurrent requests share one build") {
+    AutomatonCache cache(1 << 24);
+    vector<string> patterns;
+    for (int i = 0; i < 2000; ++i) patterns.push_back("word" + to_string(i));
+
+    vector<AutomatonCache::Handle> handles(8);
+    vector<thread> threads;
+    for (size_t t = 0; t < handles.size(); ++t) {
+        threads.emplace_back([&, t] { handles[t] = cache.get(patterns); });
+    }
+    for (thread &th : threads) th.join();
+
+    for (const AutomatonCache::Handle &h : handles) CHECK(h == handles[0]);
+    CHECK(cache.stats().misses == 1);
+    CHECK(cache.stats().hits == 7);
+}
+
+// ---- Бюджет дотримується, коли повільна побудова завершується останньою ----
+TEST_CASE("Budget holds when builds interleave") {
+    vector<string> big, s1 = {"alpha", "beta"}, s2 = {"gamma", "delta"};
+    for (int i = 0; i < 50000; ++i) big.push_back("pattern" + to_string(i * 7919));
+    size_t big_bytes = AutomatonCache(1 << 30).get(big)->stats().total_bytes;
+    size_t small_bytes = AutomatonCache(1 << 20).get(s1)->stats().total_bytes;
+
+    // у бюджет вкладається великий автомат або обидва малі, але не всі разом
+    size_t budget = big_bytes + small_bytes / 2;
+    AutomatonCache cache(budget);
+    thread slow([&] { cache.get(big); });
+    while (cache.stats().misses == 0) this_thread::yield();
+    cache.get(s1); // обидва малі стають новішими за великий, що ще будується
+    cache.get(s2);
+    slow.join();
+
+    AutomatonCacheStats st = cache.stats();
+    CHECK(st.bytes <= budget);
+    CHECK(st.entries == 1);
+    CHECK(st.evictions == 2);
+    cache.get(big); // великий не витіснено, поки він будувався
+    CHECK(cache.stats().hits == 1);
+}
@@ -0,0 +1,88 @@
+#include "doctest.h"
+
+#include "../src/bench_report.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static BenchResult make_result(const string &engine, vector<double> samples, size_t matches) {
+    BenchResult r;
+    r.engine = engine;
+    r.dictionary = "animals";
+    r.corpus = "zipf";
+    r.bytes = 1000;
+    r.patterns = 10;
+    r.matches = matches;
+    r.samples_us = samples;
+    return r;
+}
+
+// ---- JSON записується і читається без втрат ----
+TEST_CASE("Benchmark JSON round trip") {
+    vector<BenchResult> results = {make_result("aho", {10, 11, 12.5}, 42)};
+    results[0].counters.push_back({"cycles", 123456789});
+
+    stringstream json;
+    json.precision(3);
+    write_bench_json(json, results);
+    CHECK(json.precision() == 3); // формат потоку викликача не змінюється
+
+    vector<BenchResult> back;
+    string error;
+    REQUIRE(read_bench_json(json, back, error));
+    REQUIRE(back.size() == 1);
+    CHECK(back[0].key() == "aho/animals/zipf");
+    CHECK(back[0].matches == 42);
+    CHECK(back[0].samples_us == vector<double>({10, 11, 12.5}));
+    REQUIRE(back[0].counters.size() == 1);
+    CHECK(back[0].counters[0].second == 123456789);
+
+    stringstream broken("{\"results\": [");
+    CHECK_FALSE(read_bench_json(broken, back, error));
+    CHECK(!error.empty());
+}
+
+// ---- Регресією вважається лише значуще сповільнення понад поріг ----
+TEST_CASE("Benchmark comparison is noise aware") {
+    vector<double> base = {100, 101, 99, 102, 100, 98, 101, 100, 99, 100};
+    vector<double> slower, noisy;
+    for (double x : base) slower.push_back(x * 1.3);
+    noisy = {100, 103, 97, 102, 101, 98, 99, 104, 100, 96};
+
+    CompareOptions options;
+    vector<BenchComparison> cmp = compare_bench({make_result("aho", base, 5)},
+                                                {make_result("aho", slower, 5)}, options);
+    REQUIRE(cmp.size() == 1);
+    CHECK(cmp[0].regression);
+    CHECK(cmp[0].change == doctest::Approx(0.3));
+
+    cmp = compare_bench({make_result("aho", base, 5)}, {make_result("aho", noisy, 5)}, options);
+    CHECK_FALSE(cmp[0].regression);
+
+    cmp = compare_bench({make_result("aho", base, 5)}, {make_result("aho", base, 6)}, options);
+    CHECK(cmp[0].mismatch);
+
+    // одна ітерація не дає статистичної значущості навіть за великої зміни
+    cmp = compare_bench({make_result("aho", {100}, 5)}, {make_result("aho", {200}, 5)}, options);
+    CHECK_FALSE(cmp[0].regression);
+}
+
+// ---- Ключі лише одного із запусків не відкидаються мовчки ----
+TEST_CASE("Benchmark comparison reports missing and new keys") {
+    vector<double> samples = {100, 101, 99};
+    vector<BenchComparison> cmp =
+        compare_bench({make_result("aho", samples, 5), make_result("naive", samples, 5)},
+                      {make_result("aho", samples, 5), make_result("flat", samples, 5)}, CompareOptions());
+    REQUIRE(cmp.size() == 3);
+    CHECK(cmp[0].key == "aho/animals/zipf");
+    CHECK_FALSE(cmp[0].missing);
+    CHECK_FALSE(cmp[0].added);
+    CHECK(cmp[1].key == "flat/animals/zipf");
+    CHECK(cmp[1].added);
+    CHECK_FALSE(cmp[1].regression);
+    CHECK(cmp[2].key == "naive/animals/zipf");
+    CHECK(cmp[2].missing);
+    CHECK(cmp[2].base_p50 == doctest::Approx(100));
+}
@@ -0,0 +1,51 @@
+#include "doctest.h"
+
+#include "../src/corpus_generator.hpp"
+#include "../src/search_algorithms.hpp"
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---- Однаковий seed дає однаковий корпус ----
+TEST_CASE("Generated corpora are reproducible") {
+    vector<string> vocab = english_like_words(1000, 7);
+    CHECK(vocab == english_like_words(1000, 7));
+    CHECK(set<string>(vocab.begin(), vocab.end()).size() == vocab.size());
+
+    string a = zipf_text(4096, vocab, 1.07, 7);
+    CHECK(a.size() == 4096);
+    CHECK(a == zipf_text(4096, vocab, 1.07, 7));
+    CHECK(a != zipf_text(4096, vocab, 1.07, 8));
+
+    CHECK(random_bytes(1000, 3) == random_bytes(1000, 3));
+    CHECK(random_bytes(1000, 3).size() == 1000);
+}
+
+// ---- Форма змагальних словників ----
+TEST_CASE("Adversarial dictionaries have the requested shape") {
+    vector<string> chain = suffix_chain_dictionary(4, 'a');
+    CHECK(chain == vector<string>({"a", "aa", "aaa", "aaaa"}));
+
+    vector<string> prefix = shared_prefix_dictionary(100, 16, 1);
+    CHECK(set<string>(prefix.begin(), prefix.end()).size() == 100);
+    for (const string &w : prefix) CHECK(w.compare(0, 16, prefix[0], 0, 16) == 0);
+
+    vector<string> words = random_word_dictionary(50, 3, 5, 1);
+    for (const string &w : words) {
+        CHECK(w.size() >= 3);
+        CHECK(w.size() <= 5);
+    }
+}
+
+// ---- Щільний текст справді містить багато збігів ----
+TEST_CASE("Dense text contains many dictionary matches") {
+    vector<string> patterns = {"cat", "dog", "horse"};
+    string text = dense_text(10000, patterns, 0.9, 5);
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+    vector<size_t> counts;
+    CHECK(aho.search(text, counts) > 1000);
+}
@@ -0,0 +1,152 @@
+#include "doctest.h"
+
+#include "../src/match_server.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ---- Запити кількох клієнтів ----
+TEST_CASE("Match server answers concurrent clients like a local search") {
+    vector<vector<string>> dictionaries = {{"cat", "dog"}, {"he", "she", "his", "hers"}};
+    vector<string> texts = {"Cat and dog, CAT!", "ushers said his and hers", "", "nothing here"};
+
+    MatchServer server(2);
+    for (const vector<string> &d : dictionaries) {
+        server.dictionaries.emplace_back();
+        server.dictionaries.back().build_automaton(d);
+    }
+    string path = "/tmp/aho_match_" + to_string(getpid()) + ".sock";
+    REQUIRE(server.listen(path));
+    thread loop([&] { server.run(); });
+
+    vector<int> failures(4, 0);
+    vector<thread> clients;
+    for (int t = 0; t < 4; ++t) {
+        clients.emplace_back([&, t] {
+            int fd = match_connect(path);
+            if (fd < 0) {
+                ++failures[t];
+                return;
+            }
+            for (int round = 0; round < 20; ++round) {
+                uint32_t d = (uint32_t)((t + round) % 2);
+                const string &text = texts[(t + round) % texts.size()];
+                MatchReply reply;
+                vector<size_t> expected;
+                size_t total = server.dictionaries[d].search(text, expected);
+                if (!match_request(fd, d, text, reply) || reply.status != MATCH_OK || reply.total != total) {
+                    ++failures[t];
+                    continue;
+                }
+                vector<size_t> got(expected.size(), 0);
+                for (const MatchCount &c : reply.counts) got[c.pattern] = c.count;
+                if (got != expected) ++failures[t];
+            }
+            close(fd);
+        });
+    }
+    for (thread &c : clients) c.join();
+
+    // невідомий словник не закриває з'єднання
+    int fd = match_connect(path);
+    REQUIRE(fd >= 0);
+    MatchReply reply;
+    REQUIRE(match_request(fd, 7, "cat", reply));
+    CHECK(reply.status == MATCH_UNKNOWN_DICTIONARY);
+    REQUIRE(match_request(fd, 0, "cat", reply));
+    CHECK(reply.status == MATCH_OK);
+    CHECK(reply.total == 1);
+    close(fd);
+
+    server.stop();
+    loop.join();
+
+    CHECK(failures == vector<int>(4, 0));
+    CHECK(server.requests == 4 * 20 + 2);
+    CHECK(server.batches <= server.requests);
+}
+
+// ---- Клієнт, що не читає відповідей ----
+TEST_CASE("A client that never reads replies does not stall other clients") {
+    MatchServer server(1);
+    server.dictionaries.emplace_back();
+    server.dictionaries.back().build_automaton({"cat", "dog"});
+    string path = "/tmp/aho_match_slow_" + to_string(getpid()) + ".sock";
+    REQUIRE(server.listen(path));
+    thread loop([&] { server.run(); });
+
+    // запити без читання відповідей, доки буфери сокета не заповняться
+    int slow = match_connect(path);
+    REQUIRE(slow >= 0);
+    thread flood([&] {
+        string text = "cat dog";
+        RequestHeader req = {REQUEST_MAGIC, 0, text.size()};
+        string one(reinterpret_cast<const char *>(&req), sizeof(req));
+        one += text;
+        for (int i = 0; i < 200000; ++i) {
+            if (send(slow, one.data(), one.size(), MSG_NOSIGNAL) != (ssize_t)one.size()) break;
+        }
+    });
+    usleep(300 * 1000);
+
+    // інший клієнт обслуговується; тайм-аут замість вічного очікування
+    int fd = match_connect(path);
+    REQUIRE(fd >= 0);
+    timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    MatchReply reply;
+    CHECK(match_request(fd, 0, "dog dog", reply));
+    CHECK(reply.status == MATCH_OK);
+    CHECK(reply.total == 2);
+    close(fd);
+
+    shutdown(slow, SHUT_RDWR);
+    flood.join();
+    close(slow);
+    server.stop();
+    loop.join();
+}
+
+// ---- Заголовок без тексту не виділяє всю заявлену довжину ----
+TEST_CASE("Request buffer grows only as text arrives") {
+    MatchServer server(1);
+    server.dictionaries.emplace_back();
+    server.dictionaries.back().build_automaton({"cat"});
+    string path = "/tmp/aho_match_grow_" + to_string(getpid()) + ".sock";
+    REQUIRE(server.listen(path));
+    thread loop([&] { server.run(); });
+
+    // текст надсилається частинами з паузами
+    string text(300000, 'x');
+    text.replace(299990, 3, "cat");
+    int fd = match_connect(path);
+    REQUIRE(fd >= 0);
+    RequestHeader req = {REQUEST_MAGIC, 0, text.size()};
+    REQUIRE(send(fd, &req, sizeof(req), MSG_NOSIGNAL) == (ssize_t)sizeof(req));
+    for (size_t at = 0; at < text.size(); at += 70000) {
+        size_t n = min<size_t>(70000, text.size() - at);
+        REQUIRE(send(fd, text.data() + at, n, MSG_NOSIGNAL) == (ssize_t)n);
+        usleep(10 * 1000);
+    }
+    ResponseHeader h;
+    REQUIRE(recv(fd, &h, sizeof(h), MSG_WAITALL) == (ssize_t)sizeof(h));
+    CHECK(h.status == MATCH_OK);
+    CHECK(h.total == 1);
+    MatchCount c;
+    REQUIRE(recv(fd, &c, sizeof(c), MSG_WAITALL) == (ssize_t)sizeof(c));
+    CHECK(c.count == 1);
+
+    // наступний запит на тому ж з'єднанні
+    MatchReply reply;
+    REQUIRE(match_request(fd, 0, "cat cat", reply));
+    CHECK(reply.total == 2);
+    close(fd);
+
+    server.stop();
+    loop.join();
+}
@@ -0,0 +1,38 @@
+#include "doctest.h"
+
+#include "../src/perf_counters.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// ---- Лічильники або вимірюють, або чесно повідомляють про недоступність ----
+TEST_CASE("Perf counters degrade gracefully") {
+    PerfCounters perf;
+    int calls = 0;
+    PerfSample sample = measure_perf(perf, [&]() { ++calls; });
+
+    CHECK(calls == 1);
+    if (!perf.available()) CHECK_FALSE(sample.any());
+
+    ostringstream out;
+    print_perf(out, sample, "  ");
+    if (sample.any()) CHECK(out.str().find("cycles") != string::npos);
+    else CHECK(out.str().find("n/a") != string::npos);
+}
+
+// ---- Робота потоків, запущених усередині виміру, теж рахується ----
+TEST_CASE("Perf counters include worker threads") {
+    PerfCounters perf;
+    const long ITERATIONS = 20000000;
+    PerfSample sample = measure_perf(perf, [&]() {
+        thread worker([&]() {
+            volatile long sink = 0;
+            for (long i = 0; i < ITERATIONS; ++i) sink = sink + i;
+        });
+        worker.join();
+    });
+    // сам запуск і приєднання потоку — лише тисячі інструкцій
+    if (sample.valid[PERF_INSTRUCTIONS]) CHECK(sample.value[PERF_INSTRUCTIONS] > (uint64_t)ITERATIONS);
+}
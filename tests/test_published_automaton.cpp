@@ -0,0 +1,66 @@
+#include "doctest.h"
+
+#include "../src/published_automaton.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static unique_ptr<AhoCorasick> make_automaton(const vector<string> &patterns) {
+    unique_ptr<AhoCorasick> aho(new AhoCorasick());
+    aho->build_automaton(patterns, MatchOptions());
+    return aho;
+}
+
+// ---- Читач утримує старий автомат ----
+TEST_CASE("Reader keeps the automaton it saw until it finishes") {
+    PublishedAutomaton pub(make_automaton({"old"}));
+    vector<size_t> counts;
+
+    {
+        PublishedAutomaton::Reader reader = pub.read();
+        CHECK(pub.publish(make_automaton({"new"})) == 1);
+
+        // заміна не зачіпає читача, що вже почав роботу
+        CHECK(reader->search("old new", counts) == 1);
+        CHECK(reader->patterns[0] == "old");
+        CHECK(pub.read()->patterns[0] == "new");
+        CHECK(pub.reclaim() == 1);
+    }
+
+    CHECK(pub.reclaim() == 0);
+}
+
+// ---- Фонова перебудова під навантаженням ----
+TEST_CASE("Background reloads never stall or break concurrent searches") {
+    PublishedAutomaton pub(make_automaton({"v0"}), 8);
+    atomic<bool> stop(false);
+    atomic<size_t> searches(0), bad(0);
+
+    vector<thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            vector<size_t> counts;
+            while (!stop.load()) {
+                PublishedAutomaton::Reader reader = pub.read();
+                // кожна версія словника містить рівно один шаблон
+                if (reader->search("v0 v1 v2 v3 v4 v5", counts) != 1) ++bad;
+                ++searches;
+            }
+        });
+    }
+
+    for (int version = 1; version <= 5; ++version) {
+        future<uint64_t> done = pub.reload({"v" + to_string(version)}, MatchOptions());
+        CHECK(done.get() == (uint64_t)version);
+    }
+    stop = true;
+    for (thread &th : readers) th.join();
+
+    CHECK(bad.load() == 0);
+    CHECK(searches.load() > 0);
+    CHECK(pub.reclaim() == 0);
+    CHECK(pub.read()->patterns[0] == "v5");
+}
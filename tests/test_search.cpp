@@ -4,6 +4,10 @@
 #include "../src/search_algorithms.hpp"
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+#include <sstream>
 
 using namespace std;
 
@@ -249,3 +253,686 @@ TEST_CASE("Long repeated text small stress test") {
     CHECK(naive_counts[0] == REPEAT);
     CHECK(naive_counts[1] == REPEAT);
 }
+
+// ---- Паралельний пошук збігається з послідовним ----
+TEST_CASE("Parallel search matches sequential search") {
+    vector<string> patterns = {"ana", "na", "cat", "dog"};
+    string base = "banana cat, dog and bananas ";
+    string text;
+    for (int i = 0; i < 200; ++i) text += base;
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+    vector<size_t> seq_counts;
+    size_t seq_total = aho.search(text, seq_counts);
+
+    for (unsigned workers : {1u, 2u, 3u, 7u, 16u}) {
+        vector<size_t> par_counts;
+        size_t par_total = parallel_search(aho, text, par_counts, workers);
+        CHECK(par_total == seq_total);
+        CHECK(par_counts == seq_counts);
+    }
+}
+
+// ---- Блоки лічильників вирівняні й зливаються деревом ----
+TEST_CASE("Thread counters are padded and merged") {
+    vector<string> patterns = {"cat", "dog", "cow"};
+    ThreadCounters counters(5, patterns.size());
+
+    for (size_t w = 0; w < counters.n_workers; ++w) {
+        CHECK(reinterpret_cast<uintptr_t>(counters.block(w)) % ThreadCounters::CACHE_LINE == 0);
+        counters.total(w) = naive_accumulate("cat and dog and cat", patterns, counters.block(w));
+    }
+
+    vector<size_t> merged;
+    size_t total = counters.merge(merged, 2);
+    CHECK(total == 15);
+    CHECK(merged == vector<size_t>({10, 5, 0}));
+}
+
+// ---- Розріджений результат збігається зі щільним ----
+TEST_CASE("Sparse counts match dense counts") {
+    vector<string> patterns = {"ana", "na", "cat", "", "dog"};
+    string text = "bananas and dog";
+
+    vector<size_t> dense;
+    size_t dense_total = naive_search(text, patterns, dense);
+
+    SparseCounts naive_sparse;
+    SparseCounts aho_sparse;
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+
+    CHECK(naive_search(text, patterns, naive_sparse) == dense_total);
+    CHECK(aho.search(text, aho_sparse) == dense_total);
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        CHECK(naive_sparse.count((int)i) == dense[i]);
+        CHECK(aho_sparse.count((int)i) == dense[i]);
+    }
+    CHECK(aho_sparse.touched == vector<int>({0, 1, 4}));
+}
+
+// ---- Повторне використання очищає лише зачеплені лічильники ----
+TEST_CASE("Sparse counts reuse clears only touched entries") {
+    vector<string> patterns = {"cat", "dog", "cow"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+
+    SparseCounts result;
+    aho.search("cat cat dog", result);
+    CHECK(result.total == 3);
+    CHECK(result.touched.size() == 2);
+
+    aho.search("cow", result);
+    CHECK(result.total == 1);
+    CHECK(result.touched == vector<int>({2}));
+    CHECK(result.counts == vector<size_t>({0, 0, 1}));
+}
+
+// ---- Режим записів: збіги для кожного рядка окремо ----
+TEST_CASE("Record mode reports matches per line") {
+    vector<string> patterns = {"cat", "dog"};
+    string text = "cat and dog\n\ndog dog\nno animals";
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+
+    vector<vector<size_t>> per_record;
+    vector<pair<size_t, size_t>> bounds;
+    size_t total = aho.search_records(text, [&](size_t record, size_t begin, size_t end,
+                                                const SparseCounts &hits) {
+        CHECK(record == per_record.size());
+        per_record.push_back({hits.count(0), hits.count(1)});
+        bounds.push_back({begin, end});
+    });
+
+    vector<size_t> whole;
+    CHECK(total == aho.search(text, whole));
+    REQUIRE(per_record.size() == 4);
+    CHECK(per_record[0] == vector<size_t>({1, 1}));
+    CHECK(per_record[1] == vector<size_t>({0, 0}));
+    CHECK(per_record[2] == vector<size_t>({0, 2}));
+    CHECK(per_record[3] == vector<size_t>({0, 0}));
+    CHECK(text.substr(bounds[2].first, bounds[2].second - bounds[2].first) == "dog dog");
+}
+
+// ---- Завершальний символ нового рядка не створює порожній запис ----
+TEST_CASE("Record mode with trailing newline") {
+    AhoCorasick aho;
+    aho.build_automaton({"cat"});
+
+    size_t records = 0;
+    aho.search_records("cat\ncat\n", [&](size_t, size_t, size_t, const SparseCounts &) {
+        ++records;
+    });
+    CHECK(records == 2);
+
+    records = 0;
+    aho.search_records("", [&](size_t, size_t, size_t, const SparseCounts &) {
+        ++records;
+    });
+    CHECK(records == 0);
+}
+
+// ---- Рання зупинка: наявність і перший збіг ----
+TEST_CASE("Early exit existence and first match") {
+    vector<string> patterns = {"ana", "na", "cat"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+
+    CHECK(aho.contains_any("a cat"));
+    CHECK_FALSE(aho.contains_any("dog and cow"));
+    CHECK_FALSE(aho.contains_any(""));
+
+    Match m;
+    REQUIRE(aho.first_match("my bananas", m));
+    CHECK(m.pattern == 0); // "ana" і "na" закінчуються разом, "ana" довший
+    CHECK(m.pos == 4);
+    CHECK(m.len == 3);
+    CHECK_FALSE(aho.first_match("nothing here", m));
+}
+
+// ---- Поріг кількості входжень для всіх шаблонів ----
+TEST_CASE("Early exit threshold query") {
+    vector<string> patterns = {"cat", "dog"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+
+    string text = "cat dog cat dog cat";
+    CHECK(aho.all_reach(text, 0));
+    CHECK(aho.all_reach(text, 1));
+    CHECK(aho.all_reach(text, 2));
+    CHECK_FALSE(aho.all_reach(text, 3));
+    CHECK_FALSE(aho.all_reach("cat cat cat", 1));
+
+    AhoCorasick with_empty;
+    with_empty.build_automaton({"cat", ""});
+    CHECK_FALSE(with_empty.all_reach(text, 1));
+}
+
+// ---- Статистика автомата ----
+TEST_CASE("Automaton statistics describe the trie") {
+    vector<string> patterns = {"a", "ab", "abc", "b"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+    AhoStats st = aho.stats();
+
+    // корінь, a, ab, abc, b
+    CHECK(st.states == 5);
+    CHECK(st.edges == 4);
+    CHECK(st.depth_histogram == vector<size_t>({1, 2, 1, 1}));
+    CHECK(st.fanout_histogram == vector<size_t>({2, 2, 1})); // листя abc, b; a, ab — по 1; корінь — 2
+    CHECK(st.outputs == 5); // "ab" успадковує "b" через суфіксне посилання
+    CHECK(st.node_bytes >= 5 * sizeof(AhoNode));
+    CHECK(st.total_bytes >= st.hot_bytes);
+    CHECK(!st.residency.empty());
+}
+
+// ---- Невідомі розміри кешів не видаються за рівень кешу ----
+TEST_CASE("Automaton stats report unavailable cache sizes") {
+    AhoCorasick aho;
+    aho.build_automaton({"cat"});
+    AhoStats st = aho.stats();
+    st.l1_bytes = st.l2_bytes = st.llc_bytes = 0;
+    st.residency = "unknown";
+
+    ostringstream out;
+    print_stats(out, st, "");
+    CHECK(out.str().find("cache sizes unavailable") != string::npos);
+    CHECK(out.str().find("fits in") == string::npos);
+}
+
+// ---- Шаблон без літер не рахується на кожній літері ----
+TEST_CASE("Pattern without letters never matches in automaton") {
+    vector<string> patterns = {"-", "cat", "!?"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns);
+
+    vector<size_t> counts;
+    CHECK(aho.search("a cat - !?", counts) == 1);
+    CHECK(counts == vector<size_t>({0, 1, 0}));
+}
+
+// ---- Обидва рушії однаково виконують явно задану семантику ----
+TEST_CASE("Match options are honored by both engines") {
+    vector<string> patterns = {"Cat", "t, d", "a-n"};
+    string text = "cat, dog! CAT and ant; Cat";
+
+    struct Expected {
+        MatchOptions options;
+        vector<size_t> counts;
+    };
+    vector<Expected> cases = {
+        {{CaseMode::Sensitive, Scope::Substring}, {1, 1, 0}},
+        {{CaseMode::AsciiFold, Scope::Substring}, {3, 1, 0}},
+        {{CaseMode::Sensitive, Scope::WithinWord}, {1, 0, 2}}, // "t, d" -> "td", "a-n" -> "an"
+        {{CaseMode::AsciiFold, Scope::WithinWord}, {3, 0, 2}},
+    };
+
+    for (const Expected &e : cases) {
+        vector<size_t> naive_counts, aho_counts;
+        size_t naive_total = naive_search(text, patterns, naive_counts, e.options);
+
+        AhoCorasick aho;
+        aho.build_automaton(patterns, e.options);
+        size_t aho_total = aho.search(text, aho_counts);
+
+        CHECK(naive_counts == e.counts);
+        CHECK(aho_counts == e.counts);
+        CHECK(naive_total == aho_total);
+    }
+}
+
+// ---- Нормалізація шаблонів ----
+TEST_CASE("Pattern normalization follows match options") {
+    CHECK(normalize_pattern("New-York", {CaseMode::AsciiFold, Scope::WithinWord}) == "newyork");
+    CHECK(normalize_pattern("New-York", {CaseMode::Sensitive, Scope::WithinWord}) == "NewYork");
+    CHECK(normalize_pattern("New-York", {CaseMode::AsciiFold, Scope::Substring}) == "new-york");
+    CHECK(normalize_pattern("New-York", MatchOptions()) == "New-York");
+}
+
+// ---- UTF-8 і кирилиця ----
+TEST_CASE("Unicode case folding matches Cyrillic and Latin-1") {
+    vector<string> patterns = {"кіт", "Пес", "ґанок", "café"};
+    string text = "КІТ і Кіт біля ҐАНКУ; ПЕС на ґанок. CAFÉ, Café";
+    MatchOptions options = {CaseMode::UnicodeFold, Scope::WithinWord};
+
+    vector<size_t> naive_counts, aho_counts;
+    naive_search(text, patterns, naive_counts, options);
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns, options);
+    aho.search(text, aho_counts);
+
+    CHECK(naive_counts == vector<size_t>{2, 1, 1, 2});
+    CHECK(aho_counts == naive_counts);
+
+    // позиції відповідають байтам вихідного тексту
+    Match m;
+    REQUIRE(aho.first_match(text, m));
+    CHECK(text.substr(m.pos, m.len) == "КІТ");
+
+    // без згортки Unicode великі кириличні літери не збігаються
+    aho.build_automaton(patterns, {CaseMode::AsciiFold, Scope::WithinWord});
+    aho.search(text, aho_counts);
+    CHECK(aho_counts == vector<size_t>{0, 0, 1, 1});
+}
+
+TEST_CASE("Unicode folding preserves byte length") {
+    string text = "ЇЖАК Ÿ Ā ß İ";
+    string folded = fold_case(text, CaseMode::UnicodeFold);
+    CHECK(folded.size() == text.size());
+    CHECK(folded == "їжак ÿ ā ß İ");
+    CHECK(fold_case(text, CaseMode::AsciiFold) == text);
+}
+
+// ---- Цілі слова ----
+TEST_CASE("Whole-word scope counts only bounded words") {
+    vector<string> patterns = {"cat", "cat", "at", "Кіт"};
+    string text = "cat concatenate category, CAT! at-cat\ncat кіт кітка";
+    MatchOptions options = {CaseMode::UnicodeFold, Scope::WholeWord};
+
+    vector<size_t> naive_counts, aho_counts;
+    naive_search(text, patterns, naive_counts, options);
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns, options);
+    aho.search(text, aho_counts);
+
+    CHECK(naive_counts == vector<size_t>{4, 4, 1, 1});
+    CHECK(aho_counts == naive_counts);
+
+    Match m;
+    REQUIRE(aho.first_match("concat at", m));
+    CHECK(m.pos == 7);
+    CHECK(m.len == 2);
+    CHECK(m.pattern == 2);
+
+    // межа фрагментів посеред слова не створює хибних збігів
+    string long_text;
+    for (int i = 0; i < 500; ++i) long_text += "concat cat ";
+    vector<size_t> parallel_counts;
+    parallel_search(aho, long_text, parallel_counts, 7);
+    CHECK(parallel_counts == vector<size_t>{500, 500, 0, 0});
+}
+
+// ---- Політики перекриття ----
+TEST_CASE("Match kinds resolve overlapping matches") {
+    vector<string> patterns = {"abcd", "ab", "bcde", "b", "cd"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns, MatchOptions());
+
+    auto run = [&](MatchKind kind) {
+        vector<string> found;
+        aho.find_matches("abcdef", kind, [&](const Match &m) {
+            found.push_back(patterns[m.pattern]);
+        });
+        return found;
+    };
+
+    CHECK(run(MatchKind::Overlapping) == vector<string>{"ab", "b", "abcd", "cd", "bcde"});
+    CHECK(run(MatchKind::NonOverlapping) == vector<string>{"ab", "cd"});
+    CHECK(run(MatchKind::LeftmostFirst) == vector<string>{"abcd"});
+    CHECK(run(MatchKind::LeftmostLongest) == vector<string>{"abcd"});
+
+    // «ab» має менший індекс за «abc», тож leftmost-first обирає його
+    aho.build_automaton({"ab", "abc", "c", "bc"}, MatchOptions());
+    vector<Match> first, longest;
+    aho.find_matches("abcx", MatchKind::LeftmostFirst, [&](const Match &m) { first.push_back(m); });
+    aho.find_matches("abcx", MatchKind::LeftmostLongest, [&](const Match &m) { longest.push_back(m); });
+    REQUIRE(first.size() == 2);
+    CHECK(first[0].pattern == 0);
+    CHECK(first[1].pattern == 2);
+    REQUIRE(longest.size() == 1);
+    CHECK(longest[0].pattern == 1);
+}
+
+// ---- Заміна ----
+TEST_CASE("replace_all rewrites leftmost-longest matches in one pass") {
+    AhoCorasick aho;
+    aho.build_automaton({"John", "John Smith", "555-1234", "secret"}, {CaseMode::AsciiFold, Scope::Substring});
+
+    string out;
+    size_t chunks = 0;
+    size_t n = replace_all(aho, "Call JOHN SMITH at 555-1234, not John.", {"[name]", "[name]", "[phone]"},
+                           [&](const char *data, size_t size) {
+                               out.append(data, size);
+                               ++chunks;
+                           });
+
+    CHECK(n == 3);
+    CHECK(out == "Call [name] at [phone], not [name].");
+    CHECK(chunks == 7);
+
+    // без збігів текст передається одним фрагментом
+    out.clear();
+    CHECK(replace_all(aho, "nothing here", {}, [&](const char *data, size_t size) { out.append(data, size); }) == 0);
+    CHECK(out == "nothing here");
+}
+
+// ---- Кілька словників ----
+TEST_CASE("Union automaton fills one block per dictionary") {
+    vector<Dictionary> dictionaries = {
+        {"animals", {"cat", "dog"}},
+        {"empty", {}},
+        {"tech", {"cat", "data", "at"}},
+    };
+    string text = "the cat saw a dog; data about cats";
+
+    MultiDictionary multi;
+    multi.build(dictionaries, MatchOptions());
+    DictionaryCounts result;
+    size_t total = multi.search(text, result);
+
+    size_t separate_total = 0;
+    for (size_t d = 0; d < dictionaries.size(); ++d) {
+        vector<size_t> expected;
+        separate_total += naive_search(text, dictionaries[d].patterns, expected);
+        REQUIRE(result.block_size(d) == expected.size());
+        CHECK(vector<size_t>(result.block(d), result.block(d) + result.block_size(d)) == expected);
+    }
+    CHECK(total == separate_total);
+    CHECK(result.totals == vector<size_t>{3, 0, 6});
+    CHECK(multi.find("tech") == 2);
+    CHECK(multi.find("missing") == -1);
+
+    PatternTag t = multi.tag(4);
+    CHECK(t.dictionary == 2);
+    CHECK(t.pattern == 2);
+}
+
+// ---- Матриця документ × шаблон ----
+TEST_CASE("Batch search builds the same CSR matrix for any number of workers") {
+    vector<string> patterns = {"cat", "dog", "at", "zebra"};
+    vector<string> documents = {"cat dog", "", "zebra zebra", "the cat sat on a mat", "no match", "dog"};
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns, MatchOptions());
+
+    for (unsigned workers : {1u, 2u, 3u, 16u}) {
+        CountMatrix m;
+        size_t total = batch_search(aho, documents, m, workers);
+
+        REQUIRE(m.rows() == documents.size());
+        CHECK(m.cols == patterns.size());
+        size_t expected_total = 0;
+        for (size_t d = 0; d < documents.size(); ++d) {
+            vector<size_t> expected, row(patterns.size(), 0);
+            expected_total += aho.search(documents[d], expected);
+            for (size_t k = m.row_offset[d]; k < m.row_offset[d + 1]; ++k) {
+                if (k > m.row_offset[d]) CHECK(m.columns[k - 1] < m.columns[k]);
+                CHECK(m.values[k] > 0);
+                row[m.columns[k]] = m.values[k];
+            }
+            CHECK(row == expected);
+        }
+        CHECK(total == expected_total);
+        CHECK(m.row_offset.back() == 8);
+    }
+}
+
+// ---- Найчастіші шаблони ----
+TEST_CASE("Top-K summary bounds counts and merges shards") {
+    vector<string> patterns;
+    for (int i = 0; i < 40; ++i) patterns.push_back("w" + string(1, (char)('a' + i % 26)) + string(1, (char)('a' + i / 26)));
+
+    // шаблон i зустрічається 40 - i разів, шаблони 0 і 1 — ще по 200
+    vector<string> shards(3);
+    for (int i = 0; i < 40; ++i) {
+        for (int r = 0; r < 40 - i + (i < 2 ? 200 : 0); ++r) shards[(i + r) % 3] += patterns[i] + " ";
+    }
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns, MatchOptions());
+
+    vector<size_t> exact(patterns.size(), 0);
+    for (const string &s : shards) {
+        vector<size_t> part;
+        aho.search(s, part);
+        for (size_t i = 0; i < part.size(); ++i) exact[i] += part[i];
+    }
+
+    // без витіснень зведення точне
+    TopKSummary full(64);
+    for (const string &s : shards) accumulate_top(aho, s, full);
+    vector<TopKEntry> best = full.top(3);
+    REQUIRE(best.size() == 3);
+    CHECK(best[0].pattern == 0);
+    CHECK(best[0].count == exact[0]);
+    CHECK(best[0].error == 0);
+    CHECK(best[1].pattern == 1);
+    CHECK(best[2].pattern == 2);
+    CHECK(best[2].count == exact[2]);
+
+    auto check_bounds = [&](const TopKSummary &s) {
+        size_t total = 0;
+        for (size_t c : exact) total += c;
+        CHECK(s.total == total);
+        for (const TopKEntry &e : s.heap) {
+            CHECK(e.count >= exact[e.pattern]);
+            CHECK(e.count - e.error <= exact[e.pattern]);
+        }
+        // частіші за total / capacity відстежуються обов'язково
+        vector<TopKEntry> top = s.top(2);
+        REQUIRE(top.size() == 2);
+        CHECK(((top[0].pattern == 0 && top[1].pattern == 1) || (top[0].pattern == 1 && top[1].pattern == 0)));
+    };
+
+    TopKSummary single(8);
+    for (const string &s : shards) accumulate_top(aho, s, single);
+    CHECK(single.heap.size() == 8);
+    check_bounds(single);
+
+    TopKSummary merged(8);
+    for (const string &s : shards) {
+        TopKSummary shard(8);
+        accumulate_top(aho, s, shard);
+        merged.merge(shard);
+    }
+    CHECK(merged.heap.size() == 8);
+    check_bounds(merged);
+}
+
+// ---- Потоковий пошук ----
+TEST_CASE("Stream scanner finds matches across chunk boundaries") {
+    vector<string> patterns = {"cat", "catalog", "log", "dog", "Ab"};
+    string text = "a catalog of dogs, cat log; catalog\nab AB dog";
+
+    for (const MatchOptions &options : {MatchOptions(), MatchOptions{CaseMode::AsciiFold, Scope::WithinWord},
+                                        MatchOptions{CaseMode::AsciiFold, Scope::WholeWord}}) {
+        AhoCorasick aho;
+        aho.build_automaton(patterns, options);
+        vector<size_t> expected;
+        size_t expected_total = aho.search(text, expected);
+
+        for (size_t step : {1u, 2u, 5u, 64u}) {
+            StreamScanner scanner(aho);
+            SparseCounts hits;
+            hits.reset(patterns.size());
+            size_t total = 0;
+            for (size_t at = 0; at < text.size(); at += step) {
+                total += scanner.feed(text.data() + at, min(step, text.size() - at), hits);
+            }
+            total += scanner.finish(hits);
+
+            CHECK(total == expected_total);
+            CHECK(hits.total == expected_total);
+            for (size_t i = 0; i < patterns.size(); ++i) CHECK(hits.count((int)i) == expected[i]);
+            CHECK(scanner.consumed == 0);
+        }
+    }
+}
+
+// ---- Наближені лічильники ----
+TEST_CASE("Count-Min sketch overestimates within its bound and merges across threads") {
+    vector<string> patterns;
+    for (int i = 0; i < 500; ++i) patterns.push_back("p" + to_string(i) + "q");
+    string text;
+    for (int i = 0; i < 500; ++i) {
+        for (int r = 0; r < 1 + (i % 7) * (i % 5); ++r) text += patterns[i] + " ";
+    }
+
+    AhoCorasick aho;
+    aho.build_automaton(patterns, MatchOptions());
+    vector<size_t> exact;
+    size_t total = aho.search(text, exact);
+
+    CountMinSketch sketch(0.01, 0.01);
+    CHECK(sketch.width == 512);
+    CHECK(sketch.depth == 5);
+    CHECK(accumulate_sketch(aho, text, sketch) == total);
+    CHECK(sketch.total == total);
+
+    size_t within = 0;
+    for (size_t i = 0; i < patterns.size(); ++i) {
+        size_t est = sketch.estimate((int)i);
+        CHECK(est >= exact[i]);
+        if (est - exact[i] <= sketch.error_bound()) ++within;
+    }
+    CHECK(within >= patterns.size() * 95 / 100);
+
+    // кожен потік веде власний ескіз, злиття дає той самий ескіз
+    size_t half = text.size() / 2;
+    while (text[half] != ' ') ++half;
+    vector<string> parts = {text.substr(0, half), text.substr(half)};
+    vector<CountMinSketch> local(2, CountMinSketch(0.01, 0.01));
+    vector<thread> pool;
+    for (size_t t = 0; t < 2; ++t) pool.emplace_back([&, t] { accumulate_sketch(aho, parts[t], local[t]); });
+    for (thread &th : pool) th.join();
+    CHECK(local[0].merge(local[1]));
+    CHECK(local[0].cells == sketch.cells);
+    CHECK(local[0].total == total);
+
+    CountMinSketch other(0.1, 0.01);
+    CHECK_FALSE(local[0].merge(other));
+    other.add(3, 5);
+    CHECK(other.estimate(3) >= 5);
+    other.clear();
+    CHECK(other.estimate(3) == 0);
+}
+
+// ---- Рядок і стовпець збігу ----
+TEST_CASE("Line cursor locates match positions") {
+    for (size_t n = 0; n < 40; ++n) {
+        for (size_t shift = 0; shift < 8; ++shift) {
+            string s(shift + n, 'x');
+            for (size_t i = shift; i < s.size(); i += 1 + i % 3) s[i] = '\n';
+            size_t expected = 0;
+            for (size_t i = shift; i < s.size(); ++i) expected += s[i] == '\n';
+            CHECK(count_newlines(s.data() + shift, n) == expected);
+        }
+    }
+
+    // щільні '\n': понад 255 в одному блоці з 255 слів і понад 2040 загалом
+    for (size_t size : {256u, 2040u, 2048u, 2041u * 8, 100000u}) {
+        string all_nl(size, '\n');
+        CHECK(count_newlines(all_nl.data(), size) == (size_t)count(all_nl.begin(), all_nl.end(), '\n'));
+        string every_other;
+        for (size_t i = 0; i < size; ++i) every_other += i % 2 ? '\n' : 'a';
+        CHECK(count_newlines(every_other.data(), size) ==
+              (size_t)count(every_other.begin(), every_other.end(), '\n'));
+    }
+    string many;
+    for (int i = 0; i < 1000; ++i) many += "a\n";
+    CHECK(count_newlines(many.data(), many.size()) == 1000);
+    LineCursor far(many);
+    LineColumn last = far.locate(many.size() - 1);
+    CHECK(last.line == 1000);
+    CHECK(last.column == 2);
+    CHECK(far.locate(many.size()).line == 1001);
+    CHECK(far.locate(1).line == 1);
+
+    string text = "first line cat\n\ndog and cat\r\n  catdog\nlast";
+    LineCursor cursor(text);
+    auto naive = [&](size_t pos) {
+        LineColumn lc = {1, 1};
+        for (size_t i = 0; i < pos; ++i) {
+            if (text[i] == '\n') lc = {lc.line + 1, 1};
+            else ++lc.column;
+        }
+        return lc;
+    };
+    for (size_t pos : {0u, 3u, 14u, 15u, 16u, 20u, 40u, 5u, 17u, 0u, 42u}) {
+        LineColumn got = cursor.locate(pos);
+        LineColumn want = naive(pos);
+        CHECK(got.line == want.line);
+        CHECK(got.column == want.column);
+    }
+
+    AhoCorasick aho;
+    aho.build_automaton({"cat", "dog", "catdog"}, MatchOptions());
+    vector<LineColumn> found;
+    size_t n = find_located(aho, text, MatchKind::Overlapping, [&](const Match &m, const LineColumn &at) {
+        LineColumn want = naive(m.pos);
+        CHECK(at.line == want.line);
+        CHECK(at.column == want.column);
+        found.push_back(at);
+    });
+    CHECK(n == 6);
+    REQUIRE(found.size() == 6);
+    CHECK(found[0].line == 1);
+    CHECK(found[0].column == 12);
+    CHECK(found[1].line == 3);
+    CHECK(found[1].column == 1);
+}
+
+// ---- Фрагменти з контекстом ----
+TEST_CASE("Snippets view the original buffer and merge overlaps") {
+    // "ї" — два байти; контекст не має розривати символ
+    string text = "alpha cat beta\r\nїїcat dog gamma\nzeta";
+
+    string_view sv = snippet_around(text, 6, 3, 4, SnippetClamp::Bytes);
+    CHECK(sv == "pha cat bet");
+    CHECK(sv.data() == text.data() + 2);
+
+    size_t cat2 = text.find("cat", 10);
+    CHECK(snippet_around(text, cat2, 3, 3, SnippetClamp::Bytes) == "їcat do");
+    CHECK(snippet_around(text, 6, 3, 100, SnippetClamp::Line) == "alpha cat beta");
+    CHECK(snippet_around(text, cat2, 3, 100, SnippetClamp::Line) == "їїcat dog gamma");
+    CHECK(snippet_around(text, 0, 5, 0, SnippetClamp::Line) == "alpha");
+
+    AhoCorasick aho;
+    aho.build_automaton({"cat", "dog", "zeta"}, MatchOptions());
+
+    vector<string> snippets;
+    vector<size_t> sizes;
+    size_t n = find_snippets(aho, text, MatchKind::LeftmostLongest, 4, SnippetClamp::Line,
+                             [&](const Snippet &s, const vector<Match> &matches) {
+        CHECK(s.text.data() == text.data() + s.offset);
+        for (const Match &m : matches) {
+            CHECK(m.pos >= s.offset);
+            CHECK(m.pos + m.len <= s.offset + s.text.size());
+        }
+        snippets.push_back(string(s.text));
+        sizes.push_back(matches.size());
+        if (snippets.size() == 3) {
+            CHECK(s.at.line == 3);
+            CHECK(s.at.column == 1);
+        }
+    });
+
+    // "cat" і "dog" у другому рядку дають один фрагмент
+    CHECK(n == 3);
+    CHECK(snippets == vector<string>{"pha cat bet", "їїcat dog gam", "zeta"});
+    CHECK(sizes == vector<size_t>{1, 2, 1});
+}
+
+TEST_CASE("Snippet positions stay correct over thousands of short lines") {
+    string text;
+    for (int i = 0; i < 5000; ++i) text += i % 3 ? "x\n" : "cat\n";
+
+    AhoCorasick aho;
+    aho.build_automaton({"cat"}, MatchOptions());
+    size_t checked = 0;
+    find_snippets(aho, text, MatchKind::NonOverlapping, 2, SnippetClamp::Line,
+                  [&](const Snippet &s, const vector<Match> &) {
+        size_t line = 1 + (size_t)count(text.begin(), text.begin() + s.offset, '\n');
+        size_t start = text.rfind('\n', s.offset == 0 ? 0 : s.offset - 1);
+        size_t column = s.offset - (start == string::npos || s.offset == 0 ? 0 : start + 1) + 1;
+        CHECK(s.at.line == line);
+        CHECK(s.at.column == column);
+        CHECK(s.text == "cat");
+        ++checked;
+    });
+    CHECK(checked == 1667);
+}
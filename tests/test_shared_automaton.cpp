@@ -0,0 +1,80 @@
+#include "doctest.h"
+
+#include "../src/shared_automaton.hpp"
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ---- Образ у звичайній пам'яті ----
+TEST_CASE("Flat image searches like the automaton it was written from") {
+    vector<string> patterns = {"he", "she", "his", "hers", "Кіт"};
+    string text = "ushers; She said HIS cat is his, КІТ and кіт.";
+
+    for (Scope scope : {Scope::Substring, Scope::WithinWord, Scope::WholeWord}) {
+        AhoCorasick aho;
+        aho.build_automaton(patterns, {CaseMode::UnicodeFold, scope});
+
+        // образ копіюється за іншою адресою, щоб перевірити відсутність вказівників
+        vector<uint64_t> first(flat_size(aho) / 8 + 1), second(first.size());
+        write_flat(aho, first.data());
+        second = first;
+        first.assign(first.size(), 0);
+
+        FlatAutomatonView view;
+        REQUIRE(view.attach(second.data(), second.size() * 8));
+
+        vector<size_t> expected, got;
+        size_t total = aho.search(text, expected);
+        CHECK(view.search(text, got) == total);
+        CHECK(got == expected);
+    }
+}
+
+TEST_CASE("Damaged flat image is rejected") {
+    AhoCorasick aho;
+    aho.build_automaton({"abc"}, MatchOptions());
+    vector<uint64_t> image(flat_size(aho) / 8 + 1);
+    write_flat(aho, image.data());
+
+    FlatAutomatonView view;
+    CHECK_FALSE(view.attach(image.data(), 16));
+    FlatHeader *h = reinterpret_cast<FlatHeader *>(image.data());
+    h->next_offset += 64;
+    CHECK_FALSE(view.attach(image.data(), image.size() * 8));
+    h->next_offset -= 64;
+    CHECK(view.attach(image.data(), image.size() * 8));
+    h->magic = 0;
+    CHECK_FALSE(view.attach(image.data(), image.size() * 8));
+}
+
+// ---- Спільна пам'ять між процесами ----
+TEST_CASE("Shared automaton is attached read-only by another process") {
+    string name = "/aho_test_" + to_string(getpid());
+    SharedAutomaton::remove(name);
+
+    AhoCorasick aho;
+    aho.build_automaton({"cat", "dog"}, {CaseMode::AsciiFold, Scope::WholeWord});
+    REQUIRE(SharedAutomaton::publish(name, aho));
+    CHECK_FALSE(SharedAutomaton::publish(name, aho)); // сегмент уже існує
+
+    pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        SharedAutomaton shared;
+        vector<size_t> counts;
+        bool ok = shared.attach(name) && shared.view.search("Cat, dog, cats, DOG!", counts) == 3 &&
+                  counts == vector<size_t>{1, 2};
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status));
+    CHECK(WEXITSTATUS(status) == 0);
+
+    CHECK(SharedAutomaton::remove(name));
+    SharedAutomaton missing;
+    CHECK_FALSE(missing.attach(name));
+}
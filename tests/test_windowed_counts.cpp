@@ -0,0 +1,75 @@
+#include "doctest.h"
+
+#include "../src/windowed_counts.hpp"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ---- Кошики виходять із вікна ----
+TEST_CASE("Window counts drop buckets that leave the window") {
+    AhoCorasick aho;
+    aho.build_automaton({"error", "warn"}, {CaseMode::AsciiFold, Scope::WholeWord});
+
+    // кошики по 10 одиниць часу, вікно з трьох кошиків
+    WindowedCounts w(aho, 10, 3);
+    CHECK(w.feed(0, "error warn ") == 2);
+    CHECK(w.feed(5, "ERROR ") == 1);
+    CHECK(w.feed(12, "warn error ") == 2);
+    CHECK(w.feed(25, "error") == 0); // слово ще не завершене
+    CHECK(w.count(0) == 3);
+    CHECK(w.count(1) == 2);
+
+    // кошик 0 виходить, слово "error" з кошика 2 завершується в кошику 3
+    CHECK(w.feed(31, " warn ") == 2);
+    CHECK(w.count(0) == 2);
+    CHECK(w.count(1) == 2);
+    CHECK(w.window_total == 4);
+
+    // дані не за порядком ідуть у поточний кошик
+    CHECK(w.feed(3, "warn ") == 1);
+    CHECK(w.count(1) == 3);
+
+    w.advance(45);
+    CHECK(w.count(0) == 1);
+    CHECK(w.count(1) == 2);
+
+    // стрибок, довший за вікно, очищає все
+    w.advance(1000);
+    CHECK(w.count(0) == 0);
+    CHECK(w.count(1) == 0);
+    CHECK(w.window_total == 0);
+    CHECK(w.count(7) == 0);
+}
+
+// ---- Порівняння з повторним пошуком по буферу вікна ----
+TEST_CASE("Window counts match rescanning the buffered window") {
+    vector<string> patterns = {"ab", "b", "abc", "ca"};
+    AhoCorasick aho;
+    aho.build_automaton(patterns, MatchOptions());
+
+    const uint64_t width = 4;
+    const size_t buckets = 3;
+    WindowedCounts w(aho, width, buckets);
+    vector<pair<uint64_t, string>> log;
+    uint64_t state = 7;
+    for (uint64_t t = 0; t < 60; ++t) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        string chunk;
+        for (size_t i = 0; i < (state >> 60); ++i) chunk += "abc "[(state >> (8 + 2 * i)) & 3];
+        w.feed(t, chunk);
+        log.push_back({t, chunk});
+
+        // буфер вікна; збіги, що перетинають межу кошика, рахуються в новішому
+        uint64_t first = t / width >= buckets - 1 ? (t / width - (buckets - 1)) * width : 0;
+        string before, all;
+        for (const pair<uint64_t, string> &e : log) {
+            if (e.first < first) before += e.second;
+            all += e.second;
+        }
+        vector<size_t> with_window, without;
+        aho.search(all, with_window);
+        aho.search(before, without);
+        for (size_t i = 0; i < patterns.size(); ++i) CHECK(w.count((int)i) == with_window[i] - without[i]);
+    }
+}